@@ -0,0 +1,147 @@
+// Offline tool that bakes the game's resources into a single asset pack
+//
+//   AssetBaker <resources directory> <pack file>
+//
+// Every PNG image in the textures directory is decoded to RGBA8 and every
+// shader source (.glsl) is stored as is, so that the game can map the pack
+// and use the assets without reading or decoding any other file
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <SOIL/SOIL.h>
+
+#include "asset_pack.h"
+#include "file_utils.h"
+
+namespace fs = std::filesystem;
+
+namespace game {
+
+// An asset to store in the pack
+struct BakedAsset {
+    std::string name;
+    PackEntryType type;
+    int width;
+    int height;
+    std::string data;
+};
+
+
+// Files in a directory with the given extension, sorted so that packs are
+// always written in the same order
+static std::vector<fs::path> ListFiles(const fs::path &directory, const std::string &extension)
+{
+    std::vector<fs::path> files;
+    if (fs::is_directory(directory)) {
+        for (const fs::directory_entry &entry : fs::directory_iterator(directory)) {
+            if (entry.is_regular_file() && entry.path().extension() == extension) {
+                files.push_back(entry.path());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+
+// Write all assets to a pack file
+static void WritePack(const std::string &fname, const std::vector<BakedAsset> &assets)
+{
+    // Lay out the data after the header and entry table
+    std::vector<PackEntry> entries(assets.size());
+    uint64_t offset = sizeof(PackHeader) + assets.size() * sizeof(PackEntry);
+    for (int i = 0; i < assets.size(); i++) {
+        const BakedAsset &asset = assets[i];
+        if (asset.name.size() >= sizeof(entries[i].name)) {
+            throw(std::runtime_error(std::string("Asset name is too long: ") + asset.name));
+        }
+        PackEntry &entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.name, asset.name.c_str(), asset.name.size());
+        entry.type = asset.type;
+        entry.width = asset.width;
+        entry.height = asset.height;
+        offset = (offset + pack_alignment_g - 1) / pack_alignment_g * pack_alignment_g;
+        entry.offset = offset;
+        entry.size = asset.data.size();
+        offset += entry.size;
+    }
+
+    std::ofstream f(fname.c_str(), std::ios::binary | std::ios::trunc);
+    if (!f) {
+        throw(std::runtime_error(std::string("Could not create ") + fname));
+    }
+
+    // Header and entry table
+    PackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, pack_magic_g, sizeof(header.magic));
+    header.version = pack_version_g;
+    header.num_entries = (uint32_t) entries.size();
+    f.write((const char *) &header, sizeof(header));
+    f.write((const char *) entries.data(), entries.size() * sizeof(PackEntry));
+
+    // Data, padded to the alignment of each entry
+    for (int i = 0; i < assets.size(); i++) {
+        std::string padding((size_t) entries[i].offset - (size_t) f.tellp(), '\0');
+        f.write(padding.data(), padding.size());
+        f.write(assets[i].data.data(), assets[i].data.size());
+    }
+    if (!f) {
+        throw(std::runtime_error(std::string("Could not write ") + fname));
+    }
+}
+
+} // namespace game
+
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <resources directory> <pack file>" << std::endl;
+        return 1;
+    }
+    const fs::path directory(argv[1]);
+
+    try {
+        std::vector<game::BakedAsset> assets;
+
+        // Decode the textures
+        for (const fs::path &file : game::ListFiles(directory / "textures", ".png")) {
+            game::BakedAsset asset;
+            asset.name = "/textures/" + file.filename().string();
+            asset.type = game::PACK_TEXTURE;
+            unsigned char *pixels = SOIL_load_image(file.string().c_str(), &asset.width, &asset.height, 0, SOIL_LOAD_RGBA);
+            if (!pixels) {
+                throw(std::runtime_error(std::string("Could not load texture ") + file.string()));
+            }
+            asset.data.assign((const char *) pixels, (size_t) asset.width * asset.height * 4);
+            SOIL_free_image_data(pixels);
+            assets.push_back(asset);
+        }
+
+        // Shader sources
+        for (const fs::path &file : game::ListFiles(directory, ".glsl")) {
+            game::BakedAsset asset;
+            asset.name = "/" + file.filename().string();
+            asset.type = game::PACK_TEXT;
+            asset.width = 0;
+            asset.height = 0;
+            asset.data = game::LoadTextFile(file.string().c_str());
+            assets.push_back(asset);
+        }
+
+        game::WritePack(argv[2], assets);
+        std::cout << "Baked " << assets.size() << " assets into " << argv[2] << std::endl;
+    }
+    catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "asset_pack.h"
+
+namespace game {
+
+AssetPack::AssetPack(void)
+{
+    // Initialize variables with default values
+    data_ = NULL;
+    size_ = 0;
+#ifdef _WIN32
+    file_ = NULL;
+    mapping_ = NULL;
+#endif
+}
+
+
+AssetPack::~AssetPack()
+{
+
+    Close();
+}
+
+
+bool AssetPack::Open(const std::string &fname)
+{
+    Close();
+
+    // Map the whole file
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    size_ = (size_t) size.QuadPart;
+#else
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    size_ = (size_t) st.st_size;
+#endif
+    data_ = (const unsigned char *) data;
+
+    // Check the header
+    const PackHeader *header = (const PackHeader *) data_;
+    if (size_ < sizeof(PackHeader) || memcmp(header->magic, pack_magic_g, 4) != 0 ||
+        header->version != pack_version_g ||
+        size_ < sizeof(PackHeader) + (size_t) header->num_entries * sizeof(PackEntry)) {
+        Close();
+        return false;
+    }
+
+    // Index the entries by name, skipping any that point outside the file
+    const PackEntry *entries = (const PackEntry *) (data_ + sizeof(PackHeader));
+    for (uint32_t i = 0; i < header->num_entries; i++) {
+        const PackEntry &entry = entries[i];
+        if (entry.offset > size_ || entry.size > size_ - entry.offset) {
+            continue;
+        }
+        entries_[std::string(entry.name, strnlen(entry.name, sizeof(entry.name)))] = &entry;
+    }
+    return true;
+}
+
+
+void AssetPack::Close(void)
+{
+    if (data_) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        CloseHandle((HANDLE) mapping_);
+        CloseHandle((HANDLE) file_);
+#else
+        munmap((void *) data_, size_);
+#endif
+    }
+    data_ = NULL;
+    size_ = 0;
+    entries_.clear();
+}
+
+
+const PackEntry *AssetPack::Find(const std::string &name)
+{
+    std::unordered_map<std::string, const PackEntry *>::iterator it = entries_.find(name);
+    return it != entries_.end() ? it->second : NULL;
+}
+
+} // namespace game
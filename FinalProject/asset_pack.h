@@ -0,0 +1,87 @@
+#ifndef ASSET_PACK_H_
+#define ASSET_PACK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+namespace game {
+
+    // Kinds of entries in an asset pack
+    enum PackEntryType {
+        PACK_TEXTURE = 0,  // decoded RGBA8 pixels, rows from top to bottom
+        PACK_TEXT = 1      // raw file contents
+    };
+
+    // File layout of an asset pack: a header, the entry table, then the data
+    // of every entry (each aligned to pack_alignment_g bytes)
+    const char pack_magic_g[4] = { 'O', 'C', 'P', 'K' };
+    const uint32_t pack_version_g = 1;
+    const uint64_t pack_alignment_g = 16;
+
+    struct PackHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t num_entries;
+        uint32_t reserved;
+    };
+
+    struct PackEntry {
+        char name[112];     // path relative to the resources directory
+        uint32_t type;      // PackEntryType
+        uint32_t width;     // image size in pixels (textures only)
+        uint32_t height;
+        uint32_t reserved;
+        uint64_t offset;    // from the start of the file
+        uint64_t size;      // in bytes
+    };
+
+    /*
+        AssetPack gives read-only access to a pack file written by the
+        AssetBaker tool. The file is memory-mapped, so opening it costs
+        nothing up front and entries are read straight from the mapped
+        pages without copying or decoding
+    */
+    class AssetPack {
+
+        public:
+            // Constructor and destructor
+            AssetPack(void);
+            ~AssetPack();
+
+            // Map a pack file, returns false if it is missing or invalid
+            bool Open(const std::string &fname);
+
+            // Unmap the file
+            void Close(void);
+
+            // Find an entry by name, returns NULL if the pack does not have it
+            const PackEntry *Find(const std::string &name);
+
+            // Data of an entry, valid until the pack is closed
+            inline const unsigned char *GetData(const PackEntry *entry) { return data_ + entry->offset; }
+
+            // Getters
+            inline bool IsOpen(void) { return data_ != NULL; }
+            inline size_t GetSize(void) { return size_; }
+
+        private:
+            // Mapped file
+            const unsigned char *data_;
+            size_t size_;
+
+            // Platform handles of the mapping
+#ifdef _WIN32
+            void *file_;
+            void *mapping_;
+#endif
+
+            // Entries by name
+            std::unordered_map<std::string, const PackEntry *> entries_;
+
+    }; // class AssetPack
+
+} // namespace game
+
+#endif // ASSET_PACK_H_
@@ -1,21 +0,0 @@
-#ifndef COLLECTIBLE_ITEM_H_
-#define COLLECTIBLE_ITEM_H_
-
-#include "game_object.h"
-
-namespace game {
-
-    // Inherits from GameObject
-    class CollectibleGameObject : public GameObject {
-
-    public:
-        CollectibleGameObject(const glm::vec3& position, Geometry* geom, Shader* shader, GLuint texture);
-
-        // Update function for moving the player object around
-        void Update(double delta_time) override;
-
-    }; // class CollectibleItem
-
-} // namespace game
-
-#endif
\ No newline at end of file
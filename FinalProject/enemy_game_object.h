@@ -1,24 +0,0 @@
-#ifndef ENEMY_GAME_OBJECT_H_
-#define ENEMY_GAME_OBJECT_H_
-
-#include "game_object.h"
-
-namespace game {
-
-    // Inherits from GameObject
-    class EnemyGameObject : public GameObject {
-
-    public:
-        EnemyGameObject(const glm::vec3& position, Geometry* geom, Shader* shader, GLuint texture);
-
-        // Update function for moving the player object around
-        void Update(double delta_time) override;
-
-        // Getter for the rotation position
-        glm::vec3 GetRotation();
-
-    }; // class EnemyGameObject
-
-} // namespace game
-
-#endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "entity_store.h"
+
+namespace game {
+
+// Names of the entity kinds, in the order of the EntityKind enum
+const char *entity_kind_names_g[NUM_ENTITY_KINDS] = {
+    "enemy",
+    "player",
+    "collectible",
+    "effect"
+};
+
+
+const char *GetEntityKindName(EntityKind kind)
+{
+
+    return entity_kind_names_g[kind];
+}
+
+
+EntityStore::EntityStore(void)
+{
+    num_free_ = 0;
+    num_pending_ = 0;
+    count_ = 0;
+    high_water_ = 0;
+    num_visible_ = 0;
+}
+
+
+void EntityStore::Init(int capacity)
+{
+    // Allocate every array once
+    pos_x_.assign(capacity, 0.0f);
+    pos_y_.assign(capacity, 0.0f);
+    prev_x_.assign(capacity, 0.0f);
+    prev_y_.assign(capacity, 0.0f);
+    vel_x_.assign(capacity, 0.0f);
+    vel_y_.assign(capacity, 0.0f);
+    scale_.assign(capacity, 0.0f);
+    pivot_x_.assign(capacity, 0.0f);
+    pivot_y_.assign(capacity, 0.0f);
+    chasing_.assign(capacity, 0);
+    visible_.assign(capacity, 0);
+    texture_.assign(capacity, 0);
+    slot_of_.assign(capacity, -1);
+    index_of_.assign(capacity, -1);
+    generation_.assign(capacity, 0);
+    released_.assign(capacity, 0);
+    free_.resize(capacity);
+    pending_.resize(capacity);
+
+    high_water_ = 0;
+    Reset();
+}
+
+
+EntityHandle EntityStore::Acquire(const glm::vec3 &position, float scale, int texture)
+{
+    if (num_free_ == 0) {
+        throw(std::runtime_error(std::string("Entity pool is full (capacity ") + std::to_string(GetCapacity()) + ")"));
+    }
+
+    // Take the slot on top of the free stack and append the entity
+    int slot = free_[--num_free_];
+    int i = count_++;
+    slot_of_[i] = slot;
+    index_of_[slot] = i;
+    released_[slot] = 0;
+
+    // Entities start out stationary, patrolling and visible
+    pos_x_[i] = position.x;
+    pos_y_[i] = position.y;
+    prev_x_[i] = position.x;
+    prev_y_[i] = position.y;
+    vel_x_[i] = 0.0f;
+    vel_y_[i] = 0.0f;
+    scale_[i] = scale;
+    pivot_x_[i] = position.x - 0.2f;
+    pivot_y_[i] = position.y - 0.2f;
+    chasing_[i] = 0;
+    visible_[i] = 1;
+    texture_[i] = texture;
+    num_visible_++;
+
+    if (count_ > high_water_) {
+        high_water_ = count_;
+    }
+    return EntityHandle(slot, generation_[slot]);
+}
+
+
+void EntityStore::Release(EntityHandle handle)
+{
+    int i = GetIndex(handle);
+    if (released_[handle.slot]) {
+        return;
+    }
+
+    // Hide it right away, it is removed at the end of the frame
+    released_[handle.slot] = 1;
+    SetVisible(i, false);
+    pending_[num_pending_++] = handle.slot;
+}
+
+
+void EntityStore::Flush(void)
+{
+    for (int p = 0; p < num_pending_; p++) {
+        int slot = pending_[p];
+        int hole = index_of_[slot];
+        int last = count_ - 1;
+
+        // Fill the hole with the last entity
+        // The removed entity is normally hidden since its Release
+        SetVisible(hole, false);
+        if (hole != last) {
+            MoveEntity(last, hole);
+        }
+        count_--;
+
+        // Retire the slot, the new generation makes old handles stale
+        index_of_[slot] = -1;
+        generation_[slot]++;
+        released_[slot] = 0;
+        free_[num_free_++] = slot;
+    }
+    num_pending_ = 0;
+}
+
+
+void EntityStore::Reset(void)
+{
+    // Every slot is free, with slot 0 on top of the stack
+    int capacity = GetCapacity();
+    for (int k = 0; k < capacity; k++) {
+        free_[k] = capacity - 1 - k;
+        if (index_of_[k] >= 0) {
+            generation_[k]++;
+        }
+        index_of_[k] = -1;
+        released_[k] = 0;
+    }
+    num_free_ = capacity;
+    num_pending_ = 0;
+    count_ = 0;
+    num_visible_ = 0;
+}
+
+
+void EntityStore::SavePositions(void)
+{
+
+    std::copy(pos_x_.begin(), pos_x_.begin() + count_, prev_x_.begin());
+    std::copy(pos_y_.begin(), pos_y_.begin() + count_, prev_y_.begin());
+}
+
+
+bool EntityStore::IsValid(EntityHandle handle)
+{
+
+    return handle.slot >= 0 && handle.slot < GetCapacity() &&
+           generation_[handle.slot] == handle.generation && index_of_[handle.slot] >= 0;
+}
+
+
+int EntityStore::GetIndex(EntityHandle handle)
+{
+    if (!IsValid(handle)) {
+        throw(std::runtime_error(std::string("Stale entity handle (slot ") + std::to_string(handle.slot) + ", generation " + std::to_string(handle.generation) + ")"));
+    }
+    return index_of_[handle.slot];
+}
+
+
+void EntityStore::MoveEntity(int from, int to)
+{
+    pos_x_[to] = pos_x_[from];
+    pos_y_[to] = pos_y_[from];
+    prev_x_[to] = prev_x_[from];
+    prev_y_[to] = prev_y_[from];
+    vel_x_[to] = vel_x_[from];
+    vel_y_[to] = vel_y_[from];
+    scale_[to] = scale_[from];
+    pivot_x_[to] = pivot_x_[from];
+    pivot_y_[to] = pivot_y_[from];
+    chasing_[to] = chasing_[from];
+    visible_[to] = visible_[from];
+    texture_[to] = texture_[from];
+
+    // Point the slot of the moved entity at its new index
+    int slot = slot_of_[from];
+    slot_of_[to] = slot;
+    index_of_[slot] = to;
+}
+
+} // namespace game
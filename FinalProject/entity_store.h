@@ -0,0 +1,182 @@
+#ifndef ENTITY_STORE_H_
+#define ENTITY_STORE_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace game {
+
+    // Kinds of entities, each kind is kept in its own store
+    // Listed in drawing order: sprites drawn first end up in front
+    enum EntityKind {
+        ENTITY_ENEMY = 0,
+        ENTITY_PLAYER,
+        ENTITY_COLLECTIBLE,
+        ENTITY_EFFECT,
+        NUM_ENTITY_KINDS
+    };
+
+    // Name of an entity kind, for reports
+    const char *GetEntityKindName(EntityKind kind);
+
+    // Reference to an entity of a store: the slot it was given and the
+    // generation of that slot at the time. Releasing an entity bumps the
+    // generation of its slot, so handles kept past the release are detected
+    // as stale instead of silently pointing at whatever reuses the slot
+    struct EntityHandle {
+        int slot;
+        unsigned int generation;
+
+        EntityHandle(void) : slot(-1), generation(0) {}
+        EntityHandle(int s, unsigned int g) : slot(s), generation(g) {}
+    };
+
+    /*
+        EntityStore holds a set of entities as a structure of arrays: every
+        component (position, velocity, scale, ...) lives in its own
+        contiguous array, indexed by entity. A system that only needs
+        positions and velocities streams through just those arrays, instead
+        of pulling whole objects into the cache one pointer at a time
+
+        The store is a fixed-capacity pool: every array is allocated once in
+        Init and nothing is allocated afterwards. The component arrays are
+        dense, the first GetSize() entries are the live entities in no
+        particular order. Entities are referred to by handles, which map
+        through their slot to the entity's current index. Released entities
+        stay in place until Flush, which is called at the end of a frame and
+        fills each hole with the last entity (swap and pop), so indices are
+        stable within a frame and every removal is constant time
+    */
+    class EntityStore {
+
+        public:
+            // Constructor
+            EntityStore(void);
+
+            // Allocate the arrays for a fixed number of entities
+            void Init(int capacity);
+
+            // Add an entity, returns its handle
+            // The patrol pivot starts close to the initial position
+            // Throws if the pool is full
+            EntityHandle Acquire(const glm::vec3 &position, float scale, int texture);
+
+            // Schedule an entity for removal at the next Flush
+            // Releasing an entity twice in a frame has no further effect,
+            // throws if the handle is stale
+            void Release(EntityHandle handle);
+
+            // Remove the released entities
+            void Flush(void);
+
+            // Remove all entities at once (level restart), every handle
+            // handed out so far becomes stale
+            void Reset(void);
+
+            // Remember the current positions as the previous simulation
+            // state, call before every simulation step. Rendering blends
+            // between the previous and the current positions
+            void SavePositions(void);
+
+            // Whether a handle refers to an entity that has not been removed
+            bool IsValid(EntityHandle handle);
+
+            // Current index of an entity in the component arrays
+            // Throws if the handle is stale
+            int GetIndex(EntityHandle handle);
+
+            // Handle of the entity at an index
+            inline EntityHandle GetHandle(int i) { return EntityHandle(slot_of_[i], generation_[slot_of_[i]]); }
+
+            // Number of entities, including the ones released this frame
+            inline int GetSize(void) { return count_; }
+
+            // Pool statistics: live entities, fixed capacity and the largest
+            // number of entities held at once since Init
+            inline int GetCount(void) { return count_; }
+            inline int GetCapacity(void) { return (int) scale_.size(); }
+            inline int GetHighWater(void) { return high_water_; }
+            inline bool IsFull(void) { return count_ == GetCapacity(); }
+
+            // Number of entities that are drawn, kept as they change
+            inline int GetNumVisible(void) { return num_visible_; }
+
+            // Component arrays, sized to the capacity
+            inline float *GetPositionX(void) { return pos_x_.data(); }
+            inline float *GetPositionY(void) { return pos_y_.data(); }
+            inline float *GetPreviousX(void) { return prev_x_.data(); }
+            inline float *GetPreviousY(void) { return prev_y_.data(); }
+            inline float *GetVelocityX(void) { return vel_x_.data(); }
+            inline float *GetVelocityY(void) { return vel_y_.data(); }
+            inline float *GetScale(void) { return scale_.data(); }
+            inline float *GetPivotX(void) { return pivot_x_.data(); }
+            inline float *GetPivotY(void) { return pivot_y_.data(); }
+            inline unsigned char *GetChasing(void) { return chasing_.data(); }
+            inline const unsigned char *GetVisible(void) { return visible_.data(); }
+            inline int *GetTexture(void) { return texture_.data(); }
+
+            // Access to a single entity by index
+            inline glm::vec3 GetPosition(int i) { return glm::vec3(pos_x_[i], pos_y_[i], 0.0f); }
+            inline float GetScale(int i) { return scale_[i]; }
+            inline int GetTexture(int i) { return texture_[i]; }
+            inline bool IsChasing(int i) { return chasing_[i] != 0; }
+            inline void SetPosition(int i, const glm::vec3 &position) { pos_x_[i] = position.x; pos_y_[i] = position.y; }
+            inline void Teleport(int i, const glm::vec3 &position) { SetPosition(i, position); prev_x_[i] = position.x; prev_y_[i] = position.y; }
+            inline void SetTexture(int i, int texture) { texture_[i] = texture; }
+            inline void SetChasing(int i, bool chasing) { chasing_[i] = chasing; }
+            inline void SetVisible(int i, bool visible) { num_visible_ += (int) visible - (int) visible_[i]; visible_[i] = visible; }
+
+        private:
+            // Transform
+            std::vector<float> pos_x_;
+            std::vector<float> pos_y_;
+            std::vector<float> prev_x_;
+            std::vector<float> prev_y_;
+            std::vector<float> vel_x_;
+            std::vector<float> vel_y_;
+            std::vector<float> scale_;
+
+            // Point that a patrolling entity rotates around
+            std::vector<float> pivot_x_;
+            std::vector<float> pivot_y_;
+
+            // AI state: whether the entity is chasing the player (or patrolling)
+            std::vector<unsigned char> chasing_;
+
+            // Whether the entity is drawn
+            std::vector<unsigned char> visible_;
+
+            // Texture handle (atlas region)
+            std::vector<int> texture_;
+
+            // Slot of the entity at each index
+            std::vector<int> slot_of_;
+
+            // Per slot: index of its entity, current generation and whether
+            // the entity is waiting for the next Flush
+            std::vector<int> index_of_;
+            std::vector<unsigned int> generation_;
+            std::vector<unsigned char> released_;
+
+            // Stack of free slots, the most recently freed one on top
+            // (free_[0, num_free_) are free, the array has a place for every slot)
+            std::vector<int> free_;
+            int num_free_;
+
+            // Slots released this frame, removed by Flush
+            std::vector<int> pending_;
+            int num_pending_;
+
+            // Number of entities, the most held at once and the visible ones
+            int count_;
+            int high_water_;
+            int num_visible_;
+
+            // Move the entity at index from into index to
+            void MoveEntity(int from, int to);
+
+    }; // class EntityStore
+
+} // namespace game
+
+#endif // ENTITY_STORE_H_
@@ -0,0 +1,139 @@
+#include "entity_systems.h"
+#include "simd_kernels.h"
+
+namespace game {
+
+void IntegrateSystem(EntityStore &store, float delta_time)
+{
+
+    IntegrateSystem(store, delta_time, 0, store.GetSize());
+}
+
+
+void IntegrateSystem(EntityStore &store, float delta_time, int begin, int end)
+{
+
+    GetSimdKernels().integrate(store.GetPositionX() + begin, store.GetPositionY() + begin, store.GetVelocityX() + begin, store.GetVelocityY() + begin, end - begin, delta_time);
+}
+
+
+void PatrolSystem(EntityStore &store, float cos_rot, float sin_rot)
+{
+
+    PatrolSystem(store, cos_rot, sin_rot, 0, store.GetSize());
+}
+
+
+void PatrolSystem(EntityStore &store, float cos_rot, float sin_rot, int begin, int end)
+{
+
+    GetSimdKernels().patrol(store.GetPositionX() + begin, store.GetPositionY() + begin, store.GetPivotX() + begin, store.GetPivotY() + begin, store.GetChasing() + begin, end - begin, cos_rot, sin_rot);
+}
+
+
+void ChaseSystem(EntityStore &store, const glm::vec3 &target, float gain)
+{
+
+    ChaseSystem(store, target, gain, 0, store.GetSize());
+}
+
+
+void ChaseSystem(EntityStore &store, const glm::vec3 &target, float gain, int begin, int end)
+{
+
+    GetSimdKernels().chase(store.GetPositionX() + begin, store.GetPositionY() + begin, store.GetVelocityX() + begin, store.GetVelocityY() + begin, store.GetChasing() + begin, end - begin, target.x, target.y, gain);
+}
+
+
+void DistanceSystem(EntityStore &store, const glm::vec3 &point, float *out)
+{
+
+    DistanceSystem(store, point, out, 0, store.GetSize());
+}
+
+
+void DistanceSystem(EntityStore &store, const glm::vec3 &point, float *out, int begin, int end)
+{
+
+    GetSimdKernels().distance_sq(store.GetPositionX() + begin, store.GetPositionY() + begin, end - begin, point.x, point.y, out + begin);
+}
+
+
+void StopSystem(EntityStore &store)
+{
+    int n = store.GetSize();
+    float *vel_x = store.GetVelocityX();
+    float *vel_y = store.GetVelocityY();
+
+    for (int i = 0; i < n; i++) {
+        vel_x[i] = 0.0f;
+        vel_y[i] = 0.0f;
+    }
+}
+
+
+void RenderSystem(EntityStore &store, RenderFrame *frame, float alpha, const ViewRect &view)
+{
+    int n = store.GetSize();
+    const float *pos_x = store.GetPositionX();
+    const float *pos_y = store.GetPositionY();
+    const float *prev_x = store.GetPreviousX();
+    const float *prev_y = store.GetPreviousY();
+    const float *scale = store.GetScale();
+    const unsigned char *visible = store.GetVisible();
+    const int *texture = store.GetTexture();
+
+    int culled = 0;
+    for (int i = 0; i < n; i++) {
+        if (!visible[i]) {
+            continue;
+        }
+
+        // A sprite is a square of side scale around its position
+        float x = prev_x[i] + (pos_x[i] - prev_x[i]) * alpha;
+        float y = prev_y[i] + (pos_y[i] - prev_y[i]) * alpha;
+        float half = 0.5f * scale[i];
+        if (x + half < view.min_x || x - half > view.max_x || y + half < view.min_y || y - half > view.max_y) {
+            culled++;
+            continue;
+        }
+        frame->AddSprite(glm::vec3(x, y, 0.0f), scale[i], texture[i]);
+    }
+    frame->num_culled += culled;
+}
+
+
+void RenderSystem(EntityStore &store, RenderFrame *frame, float alpha, const ViewRect &view, const std::vector<int> &candidates)
+{
+    const float *pos_x = store.GetPositionX();
+    const float *pos_y = store.GetPositionY();
+    const float *prev_x = store.GetPreviousX();
+    const float *prev_y = store.GetPreviousY();
+    const float *scale = store.GetScale();
+    const unsigned char *visible = store.GetVisible();
+    const int *texture = store.GetTexture();
+
+    int drawn = 0;
+    for (int c = 0; c < candidates.size(); c++) {
+        int i = candidates[c];
+        if (!visible[i]) {
+            continue;
+        }
+
+        // Same test as above, on the position between the two steps
+        float x = prev_x[i] + (pos_x[i] - prev_x[i]) * alpha;
+        float y = prev_y[i] + (pos_y[i] - prev_y[i]) * alpha;
+        float half = 0.5f * scale[i];
+        if (x + half < view.min_x || x - half > view.max_x || y + half < view.min_y || y - half > view.max_y) {
+            continue;
+        }
+        frame->AddSprite(glm::vec3(x, y, 0.0f), scale[i], texture[i]);
+        drawn++;
+    }
+
+    // Every visible entity that was not drawn is out of view, whether the
+    // grid or the test above rejected it, as in the full scan
+    frame->num_culled += store.GetNumVisible() - drawn;
+}
+
+} // namespace game
@@ -0,0 +1,53 @@
+#ifndef ENTITY_SYSTEMS_H_
+#define ENTITY_SYSTEMS_H_
+
+#include <glm/glm.hpp>
+
+#include "entity_store.h"
+#include "render_queue.h"
+
+namespace game {
+
+    // Systems hold the behaviour of the entities
+    // Each one runs a single loop over the component arrays it needs, with
+    // the SIMD kernels where the work is arithmetic. The batch systems also
+    // take a range of entities [begin, end), so that a store can be updated
+    // in chunks on several threads
+
+    // Move every entity by its velocity (Euler integration)
+    void IntegrateSystem(EntityStore &store, float delta_time);
+    void IntegrateSystem(EntityStore &store, float delta_time, int begin, int end);
+
+    // Rotate the patrolling entities around their pivot by the angle with
+    // the given cosine and sine
+    void PatrolSystem(EntityStore &store, float cos_rot, float sin_rot);
+    void PatrolSystem(EntityStore &store, float cos_rot, float sin_rot, int begin, int end);
+
+    // Steer the chasing entities towards a target, with a speed
+    // proportional to the distance
+    void ChaseSystem(EntityStore &store, const glm::vec3 &target, float gain);
+    void ChaseSystem(EntityStore &store, const glm::vec3 &target, float gain, int begin, int end);
+
+    // Squared distance from every entity to a point, out must hold one
+    // value per entity (indexed like the store, also for a range)
+    void DistanceSystem(EntityStore &store, const glm::vec3 &point, float *out);
+    void DistanceSystem(EntityStore &store, const glm::vec3 &point, float *out, int begin, int end);
+
+    // Stop every entity
+    void StopSystem(EntityStore &store);
+
+    // Record the visible entities as sprites of a frame, placed between
+    // their previous and current positions (alpha 0 is the previous
+    // simulation step, 1 the current one)
+    // Sprites that do not overlap the view are left out and only counted in
+    // frame->num_culled, so the renderer never sees them
+    void RenderSystem(EntityStore &store, RenderFrame *frame, float alpha, const ViewRect &view);
+
+    // Same, but only looks at the given entities (sorted indices, such as
+    // the ones a spatial index found near the view), counting all others
+    // as culled
+    void RenderSystem(EntityStore &store, RenderFrame *frame, float alpha, const ViewRect &view, const std::vector<int> &candidates);
+
+} // namespace game
+
+#endif // ENTITY_SYSTEMS_H_
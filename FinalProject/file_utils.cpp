@@ -9,17 +9,16 @@ std::string LoadTextFile(const char *filename) {
 
     // Open file
     std::ifstream f;
-    f.open(filename);
+    f.open(filename, std::ios::binary);
     if (f.fail()) {
         throw(std::ios_base::failure(std::string("Error opening file ") + std::string(filename)));
     }
 
-    // Read file into a string
-    std::string content;
-    std::string line;
-    while (std::getline(f, line)) {
-        content += line + "\n";
-    }
+    // Read the whole file into a string at once
+    f.seekg(0, std::ios::end);
+    std::string content((size_t) f.tellg(), '\0');
+    f.seekg(0, std::ios::beg);
+    f.read(&content[0], content.size());
 
     // Close file
     f.close();
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <math.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "profiler.h"
+#include "frame_pacer.h"
+
+namespace game {
+
+// Names of the vsync modes, in the order of the VsyncMode enum
+const char *vsync_mode_names_g[NUM_VSYNC_MODES] = {
+    "off",
+    "on",
+    "adaptive"
+};
+
+// Length of one sleep step
+const std::chrono::milliseconds pacer_sleep_step_g(1);
+
+// Guess of how long a sleep step takes, until one has been measured
+const double pacer_sleep_guess_g = 0.005;
+
+
+const char *GetVsyncModeName(VsyncMode mode)
+{
+
+    return vsync_mode_names_g[mode];
+}
+
+
+FramePacer::FramePacer(void)
+{
+    // Initialize variables with default values
+    frame_cap_ = 0.0;
+    idle_rate_ = 0.0;
+    sleep_mean_ = pacer_sleep_guess_g;
+    sleep_m2_ = 0.0;
+    sleep_count_ = 1;
+    num_frames_ = 0;
+    num_idle_frames_ = 0;
+    frame_mean_ = 0.0;
+    frame_m2_ = 0.0;
+    frame_max_ = 0.0;
+    sleep_time_ = 0.0;
+    spin_time_ = 0.0;
+}
+
+
+void FramePacer::SetFrameCap(double fps)
+{
+    if (fps < 0.0) {
+        throw(std::runtime_error(std::string("Invalid frame cap ") + std::to_string(fps)));
+    }
+    frame_cap_ = fps;
+}
+
+
+void FramePacer::SetIdleRate(double fps)
+{
+    if (fps < 0.0) {
+        throw(std::runtime_error(std::string("Invalid idle frame rate ") + std::to_string(fps)));
+    }
+    idle_rate_ = fps;
+}
+
+
+void FramePacer::Start(void)
+{
+    start_ = Clock::now();
+    last_frame_ = start_;
+    deadline_ = start_;
+}
+
+
+void FramePacer::Wait(bool idle)
+{
+    // The lower of the limits that apply
+    double period = frame_cap_ > 0.0 ? 1.0 / frame_cap_ : 0.0;
+    idle = idle && idle_rate_ > 0.0;
+    if (idle) {
+        period = std::max(period, 1.0 / idle_rate_);
+        num_idle_frames_++;
+    }
+
+    // Wait for the next frame. A frame that started more than a period
+    // late restarts the schedule from now
+    Clock::time_point now = Clock::now();
+    if (period > 0.0) {
+        Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+        deadline_ += step;
+        if (now > deadline_ + step) {
+            deadline_ = now;
+        }
+        WaitUntil(deadline_);
+        now = Clock::now();
+    } else {
+        deadline_ = now;
+    }
+
+    // Running mean and variance of the frame times (Welford)
+    double frame_time = std::chrono::duration<double>(now - last_frame_).count();
+    last_frame_ = now;
+    num_frames_++;
+    double delta = frame_time - frame_mean_;
+    frame_mean_ += delta / num_frames_;
+    frame_m2_ += delta * (frame_time - frame_mean_);
+    frame_max_ = std::max(frame_max_, frame_time);
+}
+
+
+double FramePacer::GetJitter(void)
+{
+
+    return num_frames_ > 1 ? sqrt(frame_m2_ / (num_frames_ - 1)) : 0.0;
+}
+
+
+double FramePacer::GetEffectiveFps(void)
+{
+    double elapsed = std::chrono::duration<double>(last_frame_ - start_).count();
+    return elapsed > 0.0 ? num_frames_ / elapsed : 0.0;
+}
+
+
+void FramePacer::WaitUntil(Clock::time_point deadline)
+{
+    PROFILE_SCOPE("Pace frame");
+
+    // Sleep while a step, as long as it has taken so far plus its spread,
+    // still ends before the deadline
+    Clock::time_point now = Clock::now();
+    while (true) {
+        double estimate = sleep_mean_ + sqrt(sleep_m2_ / sleep_count_);
+        if (std::chrono::duration<double>(deadline - now).count() <= estimate) {
+            break;
+        }
+        Clock::time_point before = now;
+        std::this_thread::sleep_for(pacer_sleep_step_g);
+        now = Clock::now();
+
+        // Learn how long a step really takes
+        double observed = std::chrono::duration<double>(now - before).count();
+        sleep_time_ += observed;
+        sleep_count_++;
+        double delta = observed - sleep_mean_;
+        sleep_mean_ += delta / sleep_count_;
+        sleep_m2_ += delta * (observed - sleep_mean_);
+    }
+
+    // Spin for the rest, letting other threads run
+    Clock::time_point spin_start = now;
+    while (now < deadline) {
+        std::this_thread::yield();
+        now = Clock::now();
+    }
+    spin_time_ += std::chrono::duration<double>(now - spin_start).count();
+}
+
+} // namespace game
@@ -0,0 +1,101 @@
+#ifndef FRAME_PACER_H_
+#define FRAME_PACER_H_
+
+#include <chrono>
+
+namespace game {
+
+    // How buffer swaps wait for the display
+    enum VsyncMode {
+        VSYNC_OFF = 0,     // present right away, tearing
+        VSYNC_ON,          // wait for the next refresh
+        VSYNC_ADAPTIVE,    // wait, unless the frame is already late (where supported)
+        NUM_VSYNC_MODES
+    };
+
+    // Name of a vsync mode, for options and reports
+    const char *GetVsyncModeName(VsyncMode mode);
+
+    /*
+        FramePacer holds the main loop to a frame rate. Sleeping alone
+        wakes up late by however long the system takes to schedule the
+        thread again, and spinning alone burns a core, so the pacer sleeps
+        in short steps while the time left is safely longer than a sleep
+        usually takes (measured as it goes), then spins for the rest
+
+        A frame that starts late does not make the next ones start early:
+        the pacer keeps the rate, not the count of frames. It also keeps
+        the statistics of the time between frames
+    */
+    class FramePacer {
+
+        public:
+            // Constructor
+            FramePacer(void);
+
+            // Most frames per second, 0 for no limit
+            void SetFrameCap(double fps);
+
+            // Frames per second while the game is in the background,
+            // 0 to run at the normal rate
+            void SetIdleRate(double fps);
+
+            // Start timing, right before the first frame
+            void Start(void);
+
+            // Wait for the start of the next frame, at the idle rate if the
+            // game is in the background
+            void Wait(bool idle);
+
+            // Getters
+            inline double GetFrameCap(void) { return frame_cap_; }
+            inline double GetIdleRate(void) { return idle_rate_; }
+
+            // Statistics of the time between frames, in seconds
+            inline long long GetNumFrames(void) { return num_frames_; }
+            inline long long GetNumIdleFrames(void) { return num_idle_frames_; }
+            inline double GetMeanFrameTime(void) { return frame_mean_; }
+            inline double GetMaxFrameTime(void) { return frame_max_; }
+            double GetJitter(void);
+            double GetEffectiveFps(void);
+
+            // Time spent waiting, asleep and spinning, in seconds
+            inline double GetSleepTime(void) { return sleep_time_; }
+            inline double GetSpinTime(void) { return spin_time_; }
+
+        private:
+            typedef std::chrono::steady_clock Clock;
+
+            // Limits
+            double frame_cap_;
+            double idle_rate_;
+
+            // Start of the last frame and of the next one
+            Clock::time_point start_;
+            Clock::time_point last_frame_;
+            Clock::time_point deadline_;
+
+            // Mean and spread of how long a short sleep really takes
+            double sleep_mean_;
+            double sleep_m2_;
+            long long sleep_count_;
+
+            // Running mean and spread of the frame times
+            long long num_frames_;
+            long long num_idle_frames_;
+            double frame_mean_;
+            double frame_m2_;
+            double frame_max_;
+
+            // Time spent waiting
+            double sleep_time_;
+            double spin_time_;
+
+            // Sleep, then spin, until a point in time
+            void WaitUntil(Clock::time_point deadline);
+
+    }; // class FramePacer
+
+} // namespace game
+
+#endif // FRAME_PACER_H_
@@ -2,19 +2,23 @@
 #include <stdlib.h>
 #include <string>
 #include <time.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp> 
-#include <SOIL/SOIL.h>
 #include <iostream>
+#include <iomanip>
 #include <math.h>
 
 #include <path_config.h>
 
 #include "sprite.h"
+#include "gl_state.h"
 #include "shader.h"
-#include "player_game_object.h"
-#include "enemy_game_object.h"
-#include "collectible_game_object.h"
+#include "entity_systems.h"
+#include "simd_kernels.h"
+#include "profiler.h"
 #include "game.h"
 
 namespace game {
@@ -31,16 +35,132 @@ const glm::vec3 viewport_background_color_g(0.0, 0.0, 1.0);
 // Directory with game resources such as textures
 const std::string resources_directory_g = RESOURCES_DIRECTORY;
 
+// Pack with the baked resources, empty when baking is turned off
+const std::string asset_pack_file_g = ASSET_PACK_FILE;
+
+// Directory of the shader program binary cache, empty to always compile
+const std::string shader_cache_directory_g = SHADER_CACHE_DIRECTORY;
+
+// Uniform buffer binding point of the Camera block in the shaders
+const GLuint camera_binding_g = 0;
+
+// Textures loaded at startup: name and file in the resources directory
+const int num_textures_g = 8;
+const char *texture_files_g[num_textures_g][2] = {
+    { "body_01", "/textures/body_01.png" },
+    { "body_02", "/textures/body_02.png" },
+    { "body_03", "/textures/body_03.png" },
+    { "stars", "/textures/stars.png" },
+    { "orb", "/textures/orb.png" },
+    { "explosion", "/textures/explosion.png" },
+    { "item", "/textures/item.png" },
+    { "body_04", "/textures/body_04.png" }
+};
+
+// Random seed used in headless mode so that benchmark runs are repeatable
+const unsigned int headless_seed_g = 12345;
+
+// Ticks between two state hashes of a recording (one per simulated second)
+const int recording_hash_interval_g = 60;
+
+// Profile written when P is pressed, unless a file was given
+const std::string default_profile_file_g = "profile.json";
+
+// How far outside the view the broadphase is searched for sprites
+// Entities move much less than this in one tick, so the broadphase, built
+// at the positions of the last tick, finds every entity drawn between the
+// last two ticks
+const float cull_margin_g = 1.0f;
+
+// Frame buffers between the simulation and the render thread: with two,
+// the simulation records a frame while the previous one is drawn
+const int render_buffers_g = 2;
+
+// Default simulation rate of the main loop (ticks per second) and the most
+// ticks run in one frame to catch up after a slow frame
+const double tick_rate_g = 60.0;
+const int max_catch_up_ticks_g = 5;
+
+// Frame rate while the window is in the background, enough to keep
+// showing the game at little cost
+const double idle_rate_g = 15.0;
+
+// Waves of enemies: a lone enemy close to the player every 7 seconds, and
+// growing swarms further out, beyond the edge of the view
+const int num_spawn_waves_g = 4;
+const SpawnWave spawn_waves_g[num_spawn_waves_g] = {
+    // start, period, count, min and max distance to the player
+    { 7.0, 7.0, 1, 2.0f, 4.0f },
+    { 30.0, 0.0, 500, 8.0f, 16.0f },
+    { 60.0, 0.0, 2000, 10.0f, 30.0f },
+    { 120.0, 0.0, 5000, 12.0f, 40.0f }
+};
+
+// Entities per chunk when a system runs on the job system
+const int job_grain_g = 2048;
+
+// Capacity of the entity pool of each kind, in the order of the EntityKind enum
+// Enemies keep spawning while the game runs, the other kinds are fixed
+const int entity_capacity_g[NUM_ENTITY_KINDS] = {
+    8192, // enemies
+    1,    // player
+    64,   // collectibles
+    2     // effects: explosion and death explosion
+};
+
 
 Game::Game(void)
 {
     // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    window_ = NULL;
+    sprite_ = NULL;
+    sprite_shader_ = NULL;
+    tile_shader_ = NULL;
+    headless_ = false;
+    framebuffer_width_ = window_width_g;
+    framebuffer_height_ = window_height_g;
+    tick_delta_time_ = 1.0 / tick_rate_g;
+    max_catch_up_ticks_ = max_catch_up_ticks_g;
+    vsync_ = VSYNC_ON;
+    pacer_.SetIdleRate(idle_rate_g);
+    broadphase_current_ = false;
+    seed_ = 0;
+    seed_set_ = false;
+    input_mode_ = INPUT_LIVE;
+    tick_ = 0;
+    hashes_checked_ = 0;
 }
 
 
-void Game::Init(void)
+void Game::Init(bool headless, int num_workers)
 {
 
+    // Initialize time
+    current_time_ = 0.0;
+
+    // Name this thread in profiles
+    PROFILE_THREAD("main");
+
+    // Start the workers that update the entities in chunks, and pick the
+    // simulation kernels before any of them uses them
+    jobs_.Init(num_workers);
+    GetSimdKernels();
+
+    // Headless mode only runs the simulation, so there is nothing else to set up
+    headless_ = headless;
+    if (headless_) {
+        resources_.Init(resources_directory_g, headless_, NULL);
+        return;
+    }
+
+    // Start the workers and let them decode textures
+    workers_.Init();
+    resources_.Init(resources_directory_g, headless_, &workers_);
+    resources_.OpenPack(asset_pack_file_g);
+    resources_.SetShaderCache(shader_cache_directory_g);
+
     // Initialize the window management library (GLFW)
     if (!glfwInit()) {
         throw(std::runtime_error(std::string("Could not initialize the GLFW library")));
@@ -68,18 +188,29 @@ void Game::Init(void)
         throw(std::runtime_error(std::string("Could not initialize the GLEW library: ") + std::string((const char *)glewGetErrorString(err))));
     }
 
-    // Set event callbacks
+    // Set event callbacks, they reach the game through the window
+    glfwSetWindowUserPointer(window_, this);
     glfwSetFramebufferSizeCallback(window_, ResizeCallback);
+    glfwGetFramebufferSize(window_, &framebuffer_width_, &framebuffer_height_);
 
     // Initialize sprite geometry
     sprite_ = new Sprite();
     sprite_->CreateGeometry();
 
     // Initialize sprite shader
-    sprite_shader_.Init((resources_directory_g+std::string("/sprite_vertex_shader.glsl")).c_str(), (resources_directory_g+std::string("/sprite_fragment_shader.glsl")).c_str());
+    sprite_shader_ = resources_.LoadShader("sprite", "/sprite_vertex_shader.glsl", "/sprite_fragment_shader.glsl");
 
-    // Initialize time
-    current_time_ = 0.0;
+    // Initialize the camera uniform buffer, shared by all shaders
+    camera_buffer_.Init(sizeof(glm::mat4), camera_binding_g);
+    sprite_shader_->SetUniformBlock("Camera", camera_binding_g);
+
+    // Initialize sprite batch
+    sprite_batch_.Init(sprite_, sprite_shader_);
+
+    // Initialize the background tiles, baked by the loading workers
+    tile_shader_ = resources_.LoadShader("tile", "/tile_vertex_shader.glsl", "/tile_fragment_shader.glsl");
+    tile_shader_->SetUniformBlock("Camera", camera_binding_g);
+    tile_map_.Init(tile_shader_, &workers_);
 }
 
 
@@ -88,21 +219,28 @@ Game::~Game()
     // Free memory for all objects
     // Only need to delete objects that are not automatically freed
     delete sprite_;
-    for (int i = 0; i < game_objects_.size(); i++){
-        delete game_objects_[i];
-    }
-    for (int i = 0; i < enemies_.size(); i++) {
-        delete enemies_[i];
+
+    // Free the OpenGL objects while the context is still there, the
+    // members are only destroyed after the window
+    if (window_) {
+        glfwMakeContextCurrent(window_);
+        sprite_batch_.Release();
+        camera_buffer_.Release();
+        tile_map_.Release();
+        resources_.ReleaseGraphics();
     }
 
     // Close window
-    glfwDestroyWindow(window_);
-    glfwTerminate();
+    if (window_) {
+        glfwDestroyWindow(window_);
+        glfwTerminate();
+    }
 }
 
 
 void Game::Setup(void)
 {
+    PROFILE_SCOPE("Setup");
 
     // Setup the game world
 
@@ -124,286 +262,941 @@ void Game::Setup(void)
     // Setting the time for invulnerability
     invTime_ = 0;
 
+    // Setting that no explosion is active
+    end_time_ = 0;
+
     // Determining if the player is dead
     dead = false;
 
-    // Setting up time for new enemy to spawn
-    spawn = 7;
+    // Setting up the collision broadphase
+    // Cells are twice the size of a sprite
+    broadphase_.Init(2.0f, 64);
+
+    // Allocate the entity pools, nothing is allocated for entities after this
+    int largest_pool = 0;
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        entities_[kind].Init(entity_capacity_g[kind]);
+        largest_pool = std::max(largest_pool, entity_capacity_g[kind]);
+    }
+    distances_.resize(largest_pool);
 
     // Setting up random number seed
-    srand(time(NULL));
-
-    // Setup the player object (position, texture, vertex count)
-    // Note that, in this specific implementation, the player object should always be the first object in the game object vector 
-    game_objects_.push_back(new PlayerGameObject(glm::vec3(0.0f, 0.0f, 0.0f), sprite_, &sprite_shader_, tex_[0]));
-
-    // Setup other objects
-    enemies_.push_back(new EnemyGameObject(glm::vec3(-2.2f, 0.0f, 0.0f), sprite_, &sprite_shader_, tex_[2]));
-    enemies_.push_back(new EnemyGameObject(glm::vec3(2.8f, 0.0f, 0.0f), sprite_, &sprite_shader_, tex_[2]));
-    game_objects_.push_back(new CollectibleGameObject(glm::vec3(-3.5f, 0.0f, 0.0f), sprite_, &sprite_shader_, tex_[6]));
-    game_objects_.push_back(new CollectibleGameObject(glm::vec3(3.5f, 0.0f, 0.0f), sprite_, &sprite_shader_, tex_[6]));
-    game_objects_.push_back(new CollectibleGameObject(glm::vec3(0.0f, 3.5f, 0.0f), sprite_, &sprite_shader_, tex_[6]));
-    game_objects_.push_back(new CollectibleGameObject(glm::vec3(-3.0f, -3.5f, 0.0f), sprite_, &sprite_shader_, tex_[6]));
-    game_objects_.push_back(new CollectibleGameObject(glm::vec3(3.5f, -3.5f, 0.0f), sprite_, &sprite_shader_, tex_[6]));
-
-    // Setting up the explosion objects
-    GameObject* explosion = new GameObject(glm::vec3(100.0f, 100.0f, 100.0f), sprite_, &sprite_shader_, tex_[5]);
-    explosion->SetScale(5.0f);
-    game_objects_.push_back(explosion);
-    GameObject* death = new GameObject(glm::vec3(100.0f, 100.0f, 100.0f), sprite_, &sprite_shader_, tex_[5]);
-    death->SetScale(5.0f);
-    game_objects_.push_back(death);
-
-    // Setup background
-    // In this specific implementation, the background is always the
-    // last object
-    GameObject *background = new GameObject(glm::vec3(0.0f, 0.0f, 0.0f), sprite_, &sprite_shader_, tex_[3]);
-    background->SetScale(10.0);
-    game_objects_.push_back(background);
+    // Headless runs use a fixed seed so that every run spawns the same enemies
+    if (!seed_set_) {
+        seed_ = headless_ ? headless_seed_g : (unsigned int) time(NULL);
+    }
+    random_.Seed(seed_);
+    spawner_.Init(spawn_waves_g, num_spawn_waves_g, &random_);
+
+    // Spawns held back by time are not repeatable, so they cannot be recorded
+    if (input_mode_ != INPUT_LIVE && !spawner_.IsRepeatable()) {
+        throw(std::runtime_error("A game with a spawn time budget cannot be recorded or replayed"));
+    }
+
+    // Start a recording of the game with the seed and the spawn budget
+    if (input_mode_ == INPUT_RECORD) {
+        recording_.Init(seed_, 1.0 / tick_delta_time_, recording_hash_interval_g, spawner_.GetCountBudget());
+    }
+
+    // Setup the player (position, scale, texture)
+    player_ = entities_[ENTITY_PLAYER].Acquire(glm::vec3(0.0f, 0.0f, 0.0f), 1.0f, resources_.AcquireTexture(player_tex_));
+
+    // Setup other entities
+    EntityStore &enemies = entities_[ENTITY_ENEMY];
+    enemies.Acquire(glm::vec3(-2.2f, 0.0f, 0.0f), 1.0f, resources_.AcquireTexture(enemy_tex_));
+    enemies.Acquire(glm::vec3(2.8f, 0.0f, 0.0f), 1.0f, resources_.AcquireTexture(enemy_tex_));
+    EntityStore &collectibles = entities_[ENTITY_COLLECTIBLE];
+    collectibles.Acquire(glm::vec3(-3.5f, 0.0f, 0.0f), 1.0f, resources_.AcquireTexture(item_tex_));
+    collectibles.Acquire(glm::vec3(3.5f, 0.0f, 0.0f), 1.0f, resources_.AcquireTexture(item_tex_));
+    collectibles.Acquire(glm::vec3(0.0f, 3.5f, 0.0f), 1.0f, resources_.AcquireTexture(item_tex_));
+    collectibles.Acquire(glm::vec3(-3.0f, -3.5f, 0.0f), 1.0f, resources_.AcquireTexture(item_tex_));
+    collectibles.Acquire(glm::vec3(3.5f, -3.5f, 0.0f), 1.0f, resources_.AcquireTexture(item_tex_));
+
+    // Setting up the explosions, hidden until something blows up
+    EntityStore &effects = entities_[ENTITY_EFFECT];
+    explosion_ = effects.Acquire(glm::vec3(0.0f, 0.0f, 0.0f), 5.0f, resources_.AcquireTexture(explosion_tex_));
+    effects.SetVisible(effects.GetIndex(explosion_), false);
+    death_explosion_ = effects.Acquire(glm::vec3(0.0f, 0.0f, 0.0f), 5.0f, resources_.AcquireTexture(explosion_tex_));
+    effects.SetVisible(effects.GetIndex(death_explosion_), false);
+
+    // Setup background, tiles showing parts of the stars image
+    if (!headless_) {
+        tile_map_.SetAtlas(resources_.GetAtlas(), resources_.AcquireTexture(background_tex_));
+    }
 }
 
 
 void Game::ResizeCallback(GLFWwindow* window, int width, int height)
 {
 
-    // Set OpenGL viewport based on framebuffer width and height
-    glViewport(0, 0, width, height);
+    // Remember the framebuffer size, the render thread sets the OpenGL
+    // viewport from it with the next frame
+    Game *game = (Game *) glfwGetWindowUserPointer(window);
+    if (game) {
+        game->framebuffer_width_ = width;
+        game->framebuffer_height_ = height;
+    }
 }
 
 
-void Game::SetTexture(GLuint w, const char *fname)
+void Game::SetAllTextures(void)
 {
-    // Bind texture buffer
-    glBindTexture(GL_TEXTURE_2D, w);
+    // Register all textures that we will need
+    for (int i = 0; i < num_textures_g; i++) {
+        resources_.AddTexture(texture_files_g[i][0], texture_files_g[i][1]);
+    }
+
+    // Look up the handles used by the game objects
+    player_tex_ = resources_.GetTexture("body_01");
+    invulnerable_tex_ = resources_.GetTexture("body_04");
+    enemy_tex_ = resources_.GetTexture("body_03");
+    item_tex_ = resources_.GetTexture("item");
+    explosion_tex_ = resources_.GetTexture("explosion");
+    background_tex_ = resources_.GetTexture("stars");
+
+    // Without an OpenGL context only the handles are needed
+    if (headless_) {
+        return;
+    }
+
+    // Load the images once and upload the atlas
+    resources_.LoadTextures();
+    sprite_batch_.SetAtlas(resources_.GetAtlas());
+}
 
-    // Load texture from a file to the buffer
-    int width, height;
-    unsigned char* image = SOIL_load_image(fname, &width, &height, 0, SOIL_LOAD_RGBA);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    SOIL_free_image_data(image);
 
-    // Texture Wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+void Game::SetSeed(unsigned int seed)
+{
 
-    // Texture Filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    seed_ = seed;
+    seed_set_ = true;
 }
 
 
-void Game::SetAllTextures(void)
+void Game::SetRecordFile(const std::string &file_name)
+{
+    if (input_mode_ == INPUT_REPLAY) {
+        throw(std::runtime_error("Cannot record a game played from a recording"));
+    }
+    record_file_ = file_name;
+    input_mode_ = INPUT_RECORD;
+}
+
+
+void Game::SetReplayFile(const std::string &file_name)
+{
+    if (input_mode_ == INPUT_RECORD) {
+        throw(std::runtime_error("Cannot record a game played from a recording"));
+    }
+
+    // Play the game of the recording, with the spawn budget it was
+    // recorded with in place of one set before
+    // A time budget is kept, for Setup to refuse it
+    recording_.Load(file_name);
+    SetSeed(recording_.GetSeed());
+    SetTickRate(recording_.GetTickRate());
+    if (spawner_.IsRepeatable()) {
+        SetSpawnBudget(recording_.GetSpawnBudget());
+    }
+    input_mode_ = INPUT_REPLAY;
+}
+
+
+int Game::GetReplayTicks(void)
+{
+
+    return input_mode_ == INPUT_REPLAY ? recording_.GetNumTicks() : 0;
+}
+
+
+void Game::SetSpawnBudget(int count)
+{
+
+    spawner_.SetCountBudget(count);
+}
+
+
+void Game::SetSpawnTimeBudget(double microseconds)
+{
+
+    spawner_.SetTimeBudget(microseconds);
+}
+
+
+void Game::SetTickRate(double rate)
+{
+    if (rate <= 0.0) {
+        throw(std::runtime_error(std::string("Invalid tick rate ") + std::to_string(rate)));
+    }
+    tick_delta_time_ = 1.0 / rate;
+}
+
+
+void Game::SetMaxCatchUpTicks(int ticks)
 {
-    // Load all textures that we will need
-    glGenTextures(NUM_TEXTURES, tex_);
-    SetTexture(tex_[0], (resources_directory_g+std::string("/textures/body_01.png")).c_str());
-    SetTexture(tex_[1], (resources_directory_g+std::string("/textures/body_02.png")).c_str());
-    SetTexture(tex_[2], (resources_directory_g+std::string("/textures/body_03.png")).c_str());
-    SetTexture(tex_[3], (resources_directory_g+std::string("/textures/stars.png")).c_str());
-    SetTexture(tex_[4], (resources_directory_g+std::string("/textures/orb.png")).c_str());
-    SetTexture(tex_[5], (resources_directory_g+std::string("/textures/explosion.png")).c_str());
-    SetTexture(tex_[6], (resources_directory_g+std::string("/textures/item.png")).c_str());
-    glBindTexture(GL_TEXTURE_2D, tex_[0]);
+    if (ticks < 1) {
+        throw(std::runtime_error(std::string("Invalid number of catch-up ticks ") + std::to_string(ticks)));
+    }
+    max_catch_up_ticks_ = ticks;
+}
+
+
+void Game::SetVsync(VsyncMode mode)
+{
+
+    vsync_ = mode;
+}
+
+
+void Game::SetFrameCap(double fps)
+{
+
+    pacer_.SetFrameCap(fps);
+}
+
+
+void Game::SetIdleRate(double fps)
+{
+
+    pacer_.SetIdleRate(fps);
 }
 
 
 void Game::MainLoop(void)
 {
+    // The simulation advances in fixed ticks, independently of the frame
+    // rate: the time of each frame goes into an accumulator and whole ticks
+    // are taken out of it. Rendering then blends the last two ticks by the
+    // fraction of a tick left over
+    double accumulator = 0.0;
+    int frames = 0;
+    int ticks = 0;
+    int overloaded_frames = 0;
+    long long sprites_drawn = 0;
+    long long sprites_culled = 0;
+    double dropped_time = 0.0;
+
+    // Hand the OpenGL context over to the render thread, this thread only
+    // simulates and records frames from now on
+    render_queue_.Init(render_buffers_g);
+    glfwMakeContextCurrent(NULL);
+    std::thread render_thread(&Game::RenderLoop, this);
+
     // Loop while the user did not close the window
     double last_time = glfwGetTime();
+    pacer_.Start();
+#ifdef USE_PROFILER
+    bool profile_key_down = false;
+#endif
     while (!glfwWindowShouldClose(window_)){
-
-        // Clear background
-        glClearColor(viewport_background_color_g.r,
-                     viewport_background_color_g.g,
-                     viewport_background_color_g.b, 0.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Set view to zoom out, centered by default at 0,0
-        float camera_zoom = 0.25f;
-        glm::mat4 view_matrix = glm::scale(glm::mat4(1.0f), glm::vec3(camera_zoom, camera_zoom, camera_zoom));
+        PROFILE_SCOPE("Frame");
 
         // Calculate delta time
         double current_time = glfwGetTime();
         double delta_time = current_time - last_time;
         last_time = current_time;
+        accumulator += delta_time;
 
         // Update other events like input handling
         glfwPollEvents();
 
-        // Update the game
-        Update(view_matrix, delta_time);
+#ifdef USE_PROFILER
+        // Write a profile of the last frames when P is pressed
+        bool profile_key = glfwGetKey(window_, GLFW_KEY_P) == GLFW_PRESS;
+        if (profile_key && !profile_key_down) {
+            WriteProfile();
+        }
+        profile_key_down = profile_key;
+#endif
+
+        // The window is idle while it is in the background or minimized
+        bool idle = !glfwGetWindowAttrib(window_, GLFW_FOCUSED) || glfwGetWindowAttrib(window_, GLFW_ICONIFIED);
+
+        // Update the game, one fixed tick at a time
+        // Idle frames are further apart, so they may take the ticks of a
+        // whole idle frame without counting as overloaded
+        int max_steps = max_catch_up_ticks_;
+        if (idle && pacer_.GetIdleRate() > 0.0) {
+            max_steps = std::max(max_steps, (int) ceil(1.0 / (pacer_.GetIdleRate() * tick_delta_time_)) + 1);
+        }
+        int steps = 0;
+        while (accumulator >= tick_delta_time_ && steps < max_steps && !breakout_) {
+            Update(tick_delta_time_);
+            accumulator -= tick_delta_time_;
+            steps++;
+        }
+        ticks += steps;
+        frames++;
+
+        // If the frame took longer than the catch-up ticks can cover, drop
+        // the rest instead of carrying it over: the game slows down for a
+        // moment rather than spending ever more time catching up
+        if (accumulator >= tick_delta_time_) {
+            double excess = accumulator - fmod(accumulator, tick_delta_time_);
+            dropped_time += excess;
+            accumulator -= excess;
+            overloaded_frames++;
+        }
+
+        // Record the game between the last two ticks for the render
+        // thread, waiting for a free frame if it is a whole ring behind
+        RenderFrame *frame;
+        {
+            PROFILE_SCOPE("Wait for render thread");
+            frame = render_queue_.BeginWrite();
+        }
+        if (!frame) {
+            break;
+        }
 
-        // Push buffer drawn in the background onto the display
-        glfwSwapBuffers(window_);
+        // Set view to zoom out, centered on the player as it is drawn
+        float alpha = (float) (accumulator / tick_delta_time_);
+        float camera_zoom = 0.25f;
+        glm::mat4 view_matrix = glm::scale(glm::mat4(1.0f), glm::vec3(camera_zoom, camera_zoom, camera_zoom));
+        view_matrix = glm::translate(view_matrix, -GetCameraCenter(alpha));
+        Render(frame, view_matrix, alpha);
+        sprites_drawn += frame->sprites.size();
+        sprites_culled += frame->num_culled;
+        render_queue_.EndWrite();
 
         // Condition to end the game
         if (breakout_) {
             break;
         }
+
+        // Hold the loop to the frame cap, or to the idle rate
+        pacer_.Wait(idle);
+    }
+
+    // Stop the render thread and take the context back
+    render_queue_.Close();
+    render_thread.join();
+    glfwMakeContextCurrent(window_);
+    if (!render_error_.empty()) {
+        throw(std::runtime_error(render_error_));
+    }
+
+#ifdef USE_PROFILER
+    // Profile of the end of the run
+    if (!profile_file_.empty()) {
+        WriteProfile();
+    }
+#endif
+
+    // Report how the fixed timestep kept up
+    std::cout << "Fixed timestep: " << ticks << " ticks of " << tick_delta_time_ * 1000.0 << " ms in " << frames << " frames, "
+              << overloaded_frames << " overloaded frames dropped " << dropped_time << " s" << std::endl;
+
+    // Report how evenly the frames came
+    auto rate = [](double fps) { return fps > 0.0 ? std::to_string((int) fps) + " fps" : std::string("none"); };
+    std::cout << "Frame pacing: vsync " << GetVsyncModeName(vsync_) << ", cap " << rate(pacer_.GetFrameCap()) << ", idle "
+              << rate(pacer_.GetIdleRate()) << "; " << pacer_.GetEffectiveFps() << " fps effective, frame time "
+              << pacer_.GetMeanFrameTime() * 1000.0 << " ms mean, " << pacer_.GetJitter() * 1000.0 << " ms jitter, "
+              << pacer_.GetMaxFrameTime() * 1000.0 << " ms max, " << pacer_.GetNumIdleFrames() << " idle frames; slept "
+              << pacer_.GetSleepTime() << " s, spun " << pacer_.GetSpinTime() << " s" << std::endl;
+
+    // Report how long each thread waited for the other
+    std::cout << "Render thread: " << render_queue_.GetNumFrames() << " frames, simulation waited "
+              << render_queue_.GetWriteWait() * 1000.0 << " ms for a free frame, renderer waited "
+              << render_queue_.GetReadWait() * 1000.0 << " ms for a recorded frame" << std::endl;
+
+    // Report how the waves were spread over the ticks
+    std::cout << "Spawning: " << spawner_.GetNumSpawned() << " enemies in " << spawner_.GetNumWaves() << " waves (" << spawner_.GetNumDropped()
+              << " dropped), at most " << spawner_.GetMaxPerTick() << " per tick over " << spawner_.GetNumBusyTicks() << " ticks" << std::endl;
+
+    // Report how many sprites the camera left out
+    if (frames > 0) {
+        std::cout << "Culling: " << (double) sprites_drawn / frames << " sprites drawn and "
+                  << (double) sprites_culled / frames << " culled per frame" << std::endl;
     }
+
+    // Report how the background streamed
+    if (tile_map_.GetNumFrames() > 0) {
+        std::cout << "Tile map: " << tile_map_.GetNumBaked() << " chunks baked, " << tile_map_.GetNumEvicted() << " evicted, "
+                  << (double) tile_map_.GetNumDrawn() / tile_map_.GetNumFrames() << " chunk draws per frame ("
+                  << tile_map_.GetNumSlots() << " slots)" << std::endl;
+    }
+
+    // Report the assets in use
+    resources_.PrintStats();
+
+    // Report how much driver work the state cache saved
+    std::cout << "OpenGL state changes: " << GLState::GetIssued() << " issued, " << GLState::GetSkipped() << " skipped" << std::endl;
+
+    FinishRecording();
 }
 
 
-void Game::Update(glm::mat4 view_matrix, double delta_time)
+void Game::SetProfileFile(const std::string &file_name)
 {
 
+    profile_file_ = file_name;
+}
+
+
+void Game::WriteProfile(void)
+{
+    std::string file_name = profile_file_.empty() ? default_profile_file_g : profile_file_;
+    int events = Profiler::WriteChromeTrace(file_name);
+    std::cout << "Wrote " << events << " profile events to " << file_name << std::endl;
+}
+
+
+void Game::RunHeadless(int ticks)
+{
+    // Latency of each simulated tick, in milliseconds
+    std::vector<double> latencies;
+    latencies.reserve(ticks);
+
+    // Run the simulation with a fixed time step until the tick count is
+    // reached or the game ends
+    double delta_time = tick_delta_time_;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks && !breakout_; i++) {
+        auto tick_start = std::chrono::steady_clock::now();
+        Update(delta_time);
+        auto tick_end = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::milli>(tick_end - tick_start).count());
+    }
+    double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Count the remaining entities
+    int entities = 0;
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        entities += entities_[kind].GetCount();
+    }
+
+    // Sort the latencies to read off the percentiles (nearest rank)
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        if (latencies.empty()) {
+            return 0.0;
+        }
+        int rank = (int) (p * (latencies.size() - 1) + 0.5);
+        return latencies[rank];
+    };
+
+    // Print the report
+    std::cout << "Headless benchmark" << std::endl;
+    std::cout << "  ticks:          " << latencies.size() << " of " << ticks << " (delta time " << delta_time << " s)" << std::endl;
+    std::cout << "  simulated time: " << current_time_ << " s" << std::endl;
+    std::cout << "  wall time:      " << wall_time << " s" << std::endl;
+    std::cout << "  frames/sec:     " << (wall_time > 0.0 ? latencies.size() / wall_time : 0.0) << std::endl;
+    std::cout << "  simd kernels:   " << GetSimdLevelName(GetSimdLevel()) << std::endl;
+    std::cout << "  job workers:    " << jobs_.GetNumWorkers() << " (" << jobs_.GetNumJobs() << " jobs, " << jobs_.GetNumStolen() << " stolen)" << std::endl;
+    std::cout << "  tick latency:   p50 " << percentile(0.50) << " ms, p90 " << percentile(0.90) << " ms, p99 " << percentile(0.99) << " ms, max " << percentile(1.0) << " ms" << std::endl;
+    std::cout << "  entities:       " << entities << std::endl;
+    std::cout << "  enemies:        " << entities_[ENTITY_ENEMY].GetCount() << std::endl;
+    std::cout << "  collectibles:   " << entities_[ENTITY_COLLECTIBLE].GetCount() << std::endl;
+    std::cout << "  lives:          " << lives_ << std::endl;
+    std::cout << "  spawns:         " << spawner_.GetNumSpawned() << " in " << spawner_.GetNumWaves() << " waves (" << spawner_.GetNumDropped()
+              << " dropped), at most " << spawner_.GetMaxPerTick() << " per tick over " << spawner_.GetNumBusyTicks() << " ticks" << std::endl;
+    std::cout << "Entity pools (live / high water / capacity)" << std::endl;
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        EntityStore &store = entities_[kind];
+        std::cout << "  " << std::left << std::setw(16) << GetEntityKindName((EntityKind) kind) << std::right
+                  << std::setw(5) << store.GetCount() << std::setw(6) << store.GetHighWater() << std::setw(6) << store.GetCapacity() << std::endl;
+    }
+    resources_.PrintStats();
+
+#ifdef USE_PROFILER
+    // Profile of the last ticks
+    if (!profile_file_.empty()) {
+        WriteProfile();
+    }
+#endif
+
+    FinishRecording();
+}
+
+
+void Game::FinishRecording(void)
+{
+    if (input_mode_ == INPUT_RECORD) {
+        recording_.Save(record_file_);
+        std::cout << "Recorded " << recording_.GetNumTicks() << " ticks and " << recording_.GetNumHashes()
+                  << " state hashes (seed " << recording_.GetSeed() << ") to " << record_file_ << std::endl;
+    } else if (input_mode_ == INPUT_REPLAY) {
+        std::cout << "Replay: " << tick_ << " of " << recording_.GetNumTicks() << " ticks, "
+                  << hashes_checked_ << " state hashes matched" << std::endl;
+        if (!replay_error_.empty()) {
+            throw(std::runtime_error(replay_error_));
+        }
+    }
+}
+
+
+uint64_t Game::HashState(void)
+{
+    // FNV-1a over the state of the game and of every entity
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&hash](const void *data, size_t size) {
+        const unsigned char *bytes = (const unsigned char *) data;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+    };
+    add(&current_time_, sizeof(current_time_));
+    add(&lives_, sizeof(lives_));
+    add(&items_, sizeof(items_));
+    add(&invulnerable_, sizeof(invulnerable_));
+    add(&dead, sizeof(dead));
+    int spawns_pending = spawner_.GetNumPending();
+    add(&spawns_pending, sizeof(spawns_pending));
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        EntityStore &store = entities_[kind];
+        int count = store.GetSize();
+        add(&count, sizeof(count));
+        add(store.GetPositionX(), count * sizeof(float));
+        add(store.GetPositionY(), count * sizeof(float));
+        add(store.GetVelocityX(), count * sizeof(float));
+        add(store.GetVelocityY(), count * sizeof(float));
+        add(store.GetScale(), count * sizeof(float));
+        add(store.GetChasing(), count);
+        add(store.GetVisible(), count);
+        add(store.GetTexture(), count * sizeof(int));
+    }
+    return hash;
+}
+
+
+void Game::Update(double delta_time)
+{
+    PROFILE_SCOPE("Update");
+
     // Update time
     current_time_ += delta_time;
 
-    // Handle user input
+    // Keep the positions of the last tick for interpolated rendering
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        entities_[kind].SavePositions();
+    }
+
+    // Input phase: read the keys of this tick, or the recorded ones
+    unsigned char input = 0;
+    if (input_mode_ == INPUT_REPLAY) {
+        // The keyboard can still stop a replay
+        input = recording_.GetInput(tick_) & ~INPUT_QUIT;
+        if (!headless_) {
+            input |= PollInput() & INPUT_QUIT;
+        }
+    } else if (!headless_) {
+        input = PollInput();
+    }
+    if (input_mode_ == INPUT_RECORD) {
+        recording_.AddInput(input);
+    }
     if (lives_ >= 0) {
-        Controls(delta_time);
-    }
-
-    // Checking to see if new enemy should spawn
-    if (current_time_ > spawn) {
-        spawn += 7;
-        int subFac = rand() % 4;
-        float xCoord = (rand() % 3 - subFac);
-        float yCoord = (rand() % 3 - subFac);
-        enemies_.push_back(new EnemyGameObject(glm::vec3(xCoord, yCoord, 0.0f), sprite_, &sprite_shader_, tex_[2]));
-    }
-
-    // Update and render all game objects
-    for (int i = 0; i < game_objects_.size(); i++) {
-        // Get the current game object
-        GameObject* current_game_object = game_objects_[i];
-
-        // Updating the player's current position in other objects
-        current_game_object->player = game_objects_[0]->GetPosition();
-
-        // Update the current game object
-        current_game_object->Update(delta_time);
-
-        for (int k = 0; k < enemies_.size(); k++) {
-
-            // Grabbing enemy from vector
-            GameObject* enObj = enemies_[k];
-
-            // Updating the player's position
-            enObj->player = game_objects_[0]->GetPosition();
-
-            // Handling the movement of the enemies
-            if (enObj->state == false && dead == false) {
-                // Patrolling (rotating) movement
-                glm::vec3 tempPos = enObj->GetPosition();
-                double xRot = (enObj->GetRotation()[0] + (tempPos[0] - enObj->GetRotation()[0]) * cos(0.5 * delta_time) - (tempPos[1] - enObj->GetRotation()[1]) * sin(0.5 * delta_time));
-                double yRot = (enObj->GetRotation()[1] + (tempPos[1] - enObj->GetRotation()[1]) * cos(0.5 * delta_time) + (tempPos[0] - enObj->GetRotation()[0]) * sin(0.5 * delta_time));
-                enObj->SetPosition(glm::vec3(xRot, yRot, 0.0));
-                //std::cout << "x: " << xRot << " y: " << yRot << std::endl;
-            } else if (dead == false) {
-                // Moving (vector) movement
-                glm::vec3 dirVec = enObj->player - enObj->GetPosition();
-                //std::cout << "X: " << dirVec[0] << "Y: " << dirVec[1] << std::endl;
-                enObj->SetVelocity(0.1f * dirVec);
-                //enObj->SetPosition(enObj->GetPosition() + 0.000001f * enObj->GetVelocity());
-            }
+        Controls(delta_time, input);
+    }
 
-            // Update the current game object
-            enObj->Update(delta_time);
+    // Spawn phase
+    SpawnEnemies();
 
-            // Compute distance between the player and the enemy
-            float distance = glm::length(enObj->GetPosition() - game_objects_[0]->GetPosition());
+    // Update phase
+    UpdateEntities(delta_time);
 
-            // If distance reaches an upper threshold, the enemy begins to follow the player
-            if (distance < 1.5 * game_objects_[0]->GetScale() && i == 0 && enObj->state == false) {
-                enObj->state = true;
+    // Collision phase
+    Collide();
+
+    // Timed events (explosions, invulnerability)
+    UpdateTimers();
+
+    // Removal phase
+    FlushEntities();
+
+    // Every few ticks, hash the state into the recording or check it
+    // against the recorded one
+    tick_++;
+    if (input_mode_ != INPUT_LIVE && tick_ % recording_.GetHashInterval() == 0) {
+        uint64_t hash = HashState();
+        int i = tick_ / recording_.GetHashInterval() - 1;
+        if (input_mode_ == INPUT_RECORD) {
+            recording_.AddHash(hash);
+        } else if (i < recording_.GetNumHashes()) {
+            if (hash != recording_.GetHash(i)) {
+                replay_error_ = std::string("Replay no longer matches the recording at tick ") + std::to_string(tick_);
+                breakout_ = true;
+            } else {
+                hashes_checked_++;
             }
+        }
+    }
+
+    // The game of a recording ends with it
+    if (input_mode_ == INPUT_REPLAY && tick_ == recording_.GetNumTicks()) {
+        breakout_ = true;
+    }
+}
+
+
+void Game::SpawnEnemies(void)
+{
+    PROFILE_SCOPE("SpawnEnemies");
+
+    // Start the waves that are due and place their next enemies around
+    // the player, within the spawn budget of a tick
+    // Once the player is gone, around where it died
+    EntityStore &player = entities_[ENTITY_PLAYER];
+    EntityStore &effects = entities_[ENTITY_EFFECT];
+    glm::vec3 center = player.IsValid(player_) ? player.GetPosition(player.GetIndex(player_)) : effects.GetPosition(effects.GetIndex(death_explosion_));
+    int spawned = spawner_.Update(current_time_, entities_[ENTITY_ENEMY], center, enemy_tex_);
+    if (spawned > 0) {
+        resources_.AcquireTexture(enemy_tex_, spawned);
+    }
+}
+
 
-            // If distance is below a lower threshold, we have a collision
-            if (distance < game_objects_[0]->GetScale() - 0.2f && dead == false) {
+void Game::UpdateEntities(double delta_time)
+{
+    PROFILE_SCOPE("UpdateEntities");
+
+    // Enemies patrol until they get close to the player, then chase it
+    // Once the player is gone nothing steers anymore. Each chunk of enemies
+    // runs all three systems while its arrays are in the cache
+    EntityStore &enemies = entities_[ENTITY_ENEMY];
+    bool steer = !dead;
+    float dt = (float) delta_time;
+
+    // The patrol rotation is the same for every enemy this frame
+    float cos_rot = (float) cos(0.5 * delta_time);
+    float sin_rot = (float) sin(0.5 * delta_time);
+    glm::vec3 target(0.0f, 0.0f, 0.0f);
+    if (steer) {
+        EntityStore &player = entities_[ENTITY_PLAYER];
+        target = player.GetPosition(player.GetIndex(player_));
+    }
+    jobs_.ParallelFor(0, enemies.GetSize(), job_grain_g, [&enemies, steer, cos_rot, sin_rot, target, dt](int begin, int end) {
+        if (steer) {
+            PatrolSystem(enemies, cos_rot, sin_rot, begin, end);
+            ChaseSystem(enemies, target, 0.1f, begin, end);
+        }
+        IntegrateSystem(enemies, dt, begin, end);
+    });
 
-                if (invulnerable_ == false) {
+    // Move all other entities
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        if (kind != ENTITY_ENEMY) {
+            IntegrateSystem(entities_[kind], dt);
+        }
+    }
+}
 
-                    // Exploding collided enemy
-                    game_objects_[game_objects_.size() - 3]->SetPosition(enObj->GetPosition());
-                    enemies_.erase(enemies_.begin() + k);
 
-                    // Exploding the player
-                    if (lives_ <= 0) {
-                        game_objects_[game_objects_.size() - 2]->SetPosition(game_objects_[0]->GetPosition());
-                        game_objects_.erase(game_objects_.begin());
-                        for (int l = 0; l < game_objects_.size(); l++) {
-                            game_objects_[l]->SetVelocity(glm::vec3(0.0f, 0.0f, 0.0f));
-                        }
-                        for (int m = 0; m < enemies_.size(); m++) {
-                            enemies_[m]->SetVelocity(glm::vec3(0.0f, 0.0f, 0.0f));
-                        }
-                        dead = true;
-                    }
+void Game::Collide(void)
+{
+    PROFILE_SCOPE("Collide");
 
-                    // Subtracting player lives and setting explosion end time
-                    lives_ -= 1;
-                    end_time_ = current_time_ + 2;
+    // Nothing can collide with the player once it has exploded
+    broadphase_current_ = false;
+    if (dead) {
+        return;
+    }
 
-                }
+    EntityStore &player = entities_[ENTITY_PLAYER];
+    EntityStore &enemies = entities_[ENTITY_ENEMY];
+    EntityStore &collectibles = entities_[ENTITY_COLLECTIBLE];
+    EntityStore &effects = entities_[ENTITY_EFFECT];
+    int player_index = player.GetIndex(player_);
+    glm::vec3 player_pos = player.GetPosition(player_index);
+    float player_scale = player.GetScale(player_index);
+
+    // Rebuild the broadphase with the current positions
+    // The player's circle covers the range at which enemies start to chase it
+    broadphase_.Clear();
+    broadphase_.Insert(0, LAYER_PLAYER, player_pos, 1.5f * player_scale);
+    broadphase_.InsertArrays(LAYER_ENEMY, enemies.GetPositionX(), enemies.GetPositionY(), enemies.GetScale(), 0.5f, enemies.GetSize(), &jobs_);
+    broadphase_.InsertArrays(LAYER_COLLECTIBLE, collectibles.GetPositionX(), collectibles.GetPositionY(), collectibles.GetScale(), 0.5f, collectibles.GetSize(), &jobs_);
+    broadphase_current_ = true;
+
+    // Ranges for chasing and for hitting the player, squared so that they
+    // compare directly with the squared distances
+    float chase_range = 1.5f * player_scale;
+    float hit_range = player_scale - 0.2f;
+    float chase_range_sq = chase_range * chase_range;
+    float hit_range_sq = hit_range * hit_range;
+
+    // Squared distances between the player and all enemies, in chunks on
+    // the workers (each chunk writes its own part of the array)
+    float *distances = distances_.data();
+    jobs_.ParallelFor(0, enemies.GetSize(), job_grain_g, [&enemies, player_pos, distances](int begin, int end) {
+        DistanceSystem(enemies, player_pos, distances, begin, end);
+    });
+
+    // Check the player against the enemies that are close by
+    // The results are applied here on the main thread, in the order of the
+    // sorted pairs, so they do not depend on how the work was split
+    broadphase_.FindPairs(LAYER_PLAYER, LAYER_ENEMY, pairs_);
+    for (int p = 0; p < pairs_.size(); p++) {
+        int enemy = pairs_[p].second;
+        float distance_sq = distances_[enemy];
+
+        // If distance reaches an upper threshold, the enemy begins to follow the player
+        if (distance_sq < chase_range_sq) {
+            enemies.SetChasing(enemy, true);
+        }
 
+        // If distance is below a lower threshold, we have a collision
+        if (distance_sq < hit_range_sq && invulnerable_ == false) {
+
+            // Exploding collided enemy
+            int explosion = effects.GetIndex(explosion_);
+            effects.Teleport(explosion, enemies.GetPosition(enemy));
+            effects.SetVisible(explosion, true);
+            resources_.ReleaseTexture(enemies.GetTexture(enemy));
+            enemies.Release(enemies.GetHandle(enemy));
+
+            // Exploding the player
+            if (lives_ <= 0) {
+                int death_explosion = effects.GetIndex(death_explosion_);
+                effects.Teleport(death_explosion, player_pos);
+                effects.SetVisible(death_explosion, true);
+                dead = true;
             }
 
-            // Rendering the enemy object
-            enObj->Render(view_matrix, current_time_);
+            // Subtracting player lives and setting explosion end time
+            lives_ -= 1;
+            end_time_ = current_time_ + 2;
+
+            // The player is gone, so nothing else can collide with it
+            if (dead) {
+                break;
+            }
         }
+    }
 
-        // Check for collision with other game objects
-        // Note the loop bounds: we avoid testing the last object since
-        // it's the background covering the whole game world
-        for (int j = i + 1; j < (game_objects_.size()-3); j++) {
-            GameObject* other_game_object = game_objects_[j];
+    // Remove the player and stop everything once it has exploded
+    if (dead) {
+        resources_.ReleaseTexture(player.GetTexture(player_index));
+        player.Release(player_);
+        for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+            StopSystem(entities_[kind]);
+        }
+        return;
+    }
 
-            // Compute distance between object i and object j
-            float distance = glm::length(current_game_object->GetPosition() - other_game_object->GetPosition());
+    // Squared distances between the player and all collectibles
+    DistanceSystem(collectibles, player_pos, distances_.data());
 
-            // If distance is below a lower threshold, we have a collision
-            if (distance < current_game_object->GetScale() - 0.2f) {
+    // Check the player against the collectibles that are close by
+    broadphase_.FindPairs(LAYER_PLAYER, LAYER_COLLECTIBLE, pairs_);
+    for (int p = 0; p < pairs_.size(); p++) {
+        int collectible = pairs_[p].second;
 
-                if (other_game_object->hostile_ == false) {
+        // If distance is below a lower threshold, we have a collision
+        if (distances_[collectible] >= hit_range_sq) {
+            continue;
+        }
 
-                    game_objects_.erase(game_objects_.begin() + j);
-                    items_++;
+        // Pick up the collectible
+        resources_.ReleaseTexture(collectibles.GetTexture(collectible));
+        collectibles.Release(collectibles.GetHandle(collectible));
+        items_++;
+
+        if (items_ == 5) {
+            items_ = 0;
+            invulnerable_ = true;
+            resources_.ReleaseTexture(player.GetTexture(player_index));
+            player.SetTexture(player_index, resources_.AcquireTexture(invulnerable_tex_));
+            invTime_ = current_time_ + 10;
+        }
+    }
+}
 
-                    if (items_ == 5) {
-                        items_ = 0;
-                        invulnerable_ = true;
-                        SetTexture(tex_[0], (resources_directory_g + std::string("/textures/body_04.png")).c_str());
-                        invTime_ = current_time_ + 10;
-                    }
 
-                }
+void Game::UpdateTimers(void)
+{
+    PROFILE_SCOPE("UpdateTimers");
+
+    // Resetting the explosion at the proper time
+    if (current_time_ >= end_time_ && end_time_ > 0) {
+        EntityStore &effects = entities_[ENTITY_EFFECT];
+        effects.SetVisible(effects.GetIndex(explosion_), false);
+        end_time_ = 0;
+
+        // Ending the game upon player death
+        if (lives_ < 0) {
+            std::cout << "Game Over" << std::endl;
+            breakout_ = true;
+        }
+    }
 
-            }
+    // Reseting the player at the proper time
+    if (current_time_ >= invTime_ && invTime_ > 0) {
+        if (!dead) {
+            EntityStore &player = entities_[ENTITY_PLAYER];
+            int player_index = player.GetIndex(player_);
+            resources_.ReleaseTexture(player.GetTexture(player_index));
+            player.SetTexture(player_index, resources_.AcquireTexture(player_tex_));
         }
+        invulnerable_ = false;
+        invTime_ = 0;
+    }
+}
 
-        // Resetting the explosion at the proper time
-        if (current_time_ >= end_time_ && end_time_ > 0) {
-            game_objects_[game_objects_.size() - 3]->SetPosition(glm::vec3(100.0f, 100.0f, 100.0f));
-            end_time_ = 0;
 
-            // Ending the game upon player death
-            if (lives_ < 0) {
-                std::cout << "Game Over" << std::endl;
-                breakout_ = true;
-            }
+void Game::FlushEntities(void)
+{
+    PROFILE_SCOPE("FlushEntities");
+
+    // Entities released during the frame leave their stores here, after
+    // every phase that refers to them by index
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        entities_[kind].Flush();
+    }
+}
+
+
+glm::vec3 Game::GetCameraCenter(float alpha)
+{
+    // The player between its last two positions, as RenderSystem draws it
+    // Once the player is gone, where it died
+    EntityStore &player = entities_[ENTITY_PLAYER];
+    if (player.IsValid(player_)) {
+        int i = player.GetIndex(player_);
+        float x = player.GetPreviousX()[i] + (player.GetPositionX()[i] - player.GetPreviousX()[i]) * alpha;
+        float y = player.GetPreviousY()[i] + (player.GetPositionY()[i] - player.GetPreviousY()[i]) * alpha;
+        return glm::vec3(x, y, 0.0f);
+    }
+    EntityStore &effects = entities_[ENTITY_EFFECT];
+    return effects.GetPosition(effects.GetIndex(death_explosion_));
+}
+
+
+void Game::Render(RenderFrame *frame, glm::mat4 view_matrix, float alpha)
+{
+    PROFILE_SCOPE("Record frame");
+
+    // Camera and viewport of the frame
+    frame->view_matrix = view_matrix;
+    frame->viewport_width = framebuffer_width_;
+    frame->viewport_height = framebuffer_height_;
+
+    // Record the entities the camera sees, kind by kind
+    // Enemies come first so that they are drawn over the other entities
+    // Enemies and collectibles can be many, so unless entities were
+    // removed since the collision phase, only the ones the broadphase finds
+    // near the view are looked at
+    ViewRect view = GetViewRect(view_matrix);
+    frame->view = view;
+    for (int kind = 0; kind < NUM_ENTITY_KINDS; kind++) {
+        EntityStore &store = entities_[kind];
+        CollisionLayer layer = kind == ENTITY_ENEMY ? LAYER_ENEMY : (kind == ENTITY_COLLECTIBLE ? LAYER_COLLECTIBLE : NUM_COLLISION_LAYERS);
+        if (broadphase_current_ && layer != NUM_COLLISION_LAYERS && broadphase_.GetCount(layer) == store.GetSize()) {
+            broadphase_.Query(layer, view.min_x - cull_margin_g, view.min_y - cull_margin_g, view.max_x + cull_margin_g, view.max_y + cull_margin_g, render_candidates_);
+            RenderSystem(store, frame, alpha, view, render_candidates_);
+        } else {
+            RenderSystem(store, frame, alpha, view);
         }
+    }
+}
+
+
+void Game::RenderLoop(void)
+{
+    PROFILE_THREAD("render");
+    try {
+        // This thread owns the OpenGL context until the loop ends
+        glfwMakeContextCurrent(window_);
+
+        // Let the swaps wait for the display, or not. Adaptive vsync skips
+        // the wait for a late frame, where the driver supports it
+        int swap_interval = vsync_ == VSYNC_OFF ? 0 : 1;
+        if (vsync_ == VSYNC_ADAPTIVE && (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear"))) {
+            swap_interval = -1;
+        }
+        glfwSwapInterval(swap_interval);
+        int viewport_width = 0;
+        int viewport_height = 0;
+
+        // Draw the frames in the order they were recorded
+        RenderFrame *frame;
+        while ((frame = render_queue_.BeginRead()) != NULL) {
+            PROFILE_SCOPE("Draw frame");
+
+            // Follow the framebuffer size
+            if (frame->viewport_width != viewport_width || frame->viewport_height != viewport_height) {
+                viewport_width = frame->viewport_width;
+                viewport_height = frame->viewport_height;
+                glViewport(0, 0, viewport_width, viewport_height);
+            }
 
-        // Reseting the player at the proper time
-        if (current_time_ >= invTime_ && invTime_ > 0) {
-            SetTexture(tex_[0], (resources_directory_g + std::string("/textures/body_01.png")).c_str());
-            invulnerable_ = false;
-            invTime_ = 0;
+            // Clear background
+            glClearColor(viewport_background_color_g.r,
+                         viewport_background_color_g.g,
+                         viewport_background_color_g.b, 0.0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Upload the camera once for every draw of the frame
+            camera_buffer_.Update(&frame->view_matrix);
+
+            // Draw everything with one draw call
+            {
+                PROFILE_GPU_SCOPE("Sprites");
+                sprite_batch_.Draw(frame->sprites);
+            }
+
+            // Draw the background after the sprites, so that the depth test
+            // only lets it fill the pixels they left
+            {
+                PROFILE_GPU_SCOPE("Tiles");
+                tile_map_.Draw(frame->view);
+            }
+            render_queue_.EndRead();
+
+            // Push buffer drawn in the background onto the display
+            {
+                PROFILE_SCOPE("Swap buffers");
+                glfwSwapBuffers(window_);
+            }
+
+            // Pick up the GPU times of earlier frames
+            Profiler::CollectGpuScopes();
         }
+        Profiler::ReleaseGpuScopes();
+    }
+    catch (std::exception &e) {
+        // Stop the simulation too, MainLoop reports the error
+        render_error_ = e.what();
+        render_queue_.Close();
+    }
+
+    // Release the context so that the main thread can take it back
+    glfwMakeContextCurrent(NULL);
+}
 
-        // Render game object
-        current_game_object->Render(view_matrix, current_time_);
+
+unsigned char Game::PollInput(void)
+{
+    unsigned char input = 0;
+    if (glfwGetKey(window_, GLFW_KEY_W) == GLFW_PRESS) {
+        input |= INPUT_UP;
     }
+    if (glfwGetKey(window_, GLFW_KEY_S) == GLFW_PRESS) {
+        input |= INPUT_DOWN;
+    }
+    if (glfwGetKey(window_, GLFW_KEY_D) == GLFW_PRESS) {
+        input |= INPUT_RIGHT;
+    }
+    if (glfwGetKey(window_, GLFW_KEY_A) == GLFW_PRESS) {
+        input |= INPUT_LEFT;
+    }
+    if (glfwGetKey(window_, GLFW_KEY_Q) == GLFW_PRESS) {
+        input |= INPUT_QUIT;
+    }
+    return input;
 }
 
-void Game::Controls(double delta_time)
+
+void Game::Controls(double delta_time, unsigned char input)
 {
-    // Get player game object
-    GameObject *player = game_objects_[0];
+    PROFILE_SCOPE("Controls");
+
+    // Get player entity
+    EntityStore &player = entities_[ENTITY_PLAYER];
+    int index = player.GetIndex(player_);
     // Get current position
-    glm::vec3 curpos = player->GetPosition();
+    glm::vec3 curpos = player.GetPosition(index);
     // Set standard forward and right directions
     glm::vec3 dir = glm::vec3(0.0, 1.0, 0.0);
     glm::vec3 right = glm::vec3(1.0, 0.0, 0.0);
@@ -412,19 +1205,19 @@ void Game::Controls(double delta_time)
     float motion_increment = speed*delta_time;
 
     // Check for player input and make changes accordingly
-    if (glfwGetKey(window_, GLFW_KEY_W) == GLFW_PRESS) {
-        player->SetPosition(curpos + motion_increment*dir);
+    if (input & INPUT_UP) {
+        player.SetPosition(index, curpos + motion_increment*dir);
     }
-    if (glfwGetKey(window_, GLFW_KEY_S) == GLFW_PRESS) {
-        player->SetPosition(curpos - motion_increment*dir);
+    if (input & INPUT_DOWN) {
+        player.SetPosition(index, curpos - motion_increment*dir);
     }
-    if (glfwGetKey(window_, GLFW_KEY_D) == GLFW_PRESS) {
-        player->SetPosition(curpos + motion_increment*right);
+    if (input & INPUT_RIGHT) {
+        player.SetPosition(index, curpos + motion_increment*right);
     }
-    if (glfwGetKey(window_, GLFW_KEY_A) == GLFW_PRESS) {
-        player->SetPosition(curpos - motion_increment*right);
+    if (input & INPUT_LEFT) {
+        player.SetPosition(index, curpos - motion_increment*right);
     }
-    if (glfwGetKey(window_, GLFW_KEY_Q) == GLFW_PRESS) {
+    if ((input & INPUT_QUIT) && window_) {
         glfwSetWindowShouldClose(window_, true);
     }
 }
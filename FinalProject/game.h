@@ -4,10 +4,24 @@
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "shader.h"
-#include "game_object.h"
+#include "entity_store.h"
+#include "spatial_hash.h"
+#include "sprite_batch.h"
+#include "render_queue.h"
+#include "resource_manager.h"
+#include "thread_pool.h"
+#include "tile_map.h"
+#include "job_system.h"
+#include "uniform_buffer.h"
+#include "random.h"
+#include "input_recording.h"
+#include "spawn_director.h"
+#include "frame_pacer.h"
 
 namespace game {
 
@@ -21,14 +35,65 @@ namespace game {
 
             // Call Init() before calling any other method
             // Initialize graphics libraries and main window
-            void Init(void); 
+            // In headless mode no window or OpenGL context is created
+            // The entity updates run on num_workers threads (0 for one per core)
+            void Init(bool headless = false, int num_workers = 0); 
 
             // Set up the game (scene, game objects, etc.)
             void Setup(void);
 
+            // Seed the world's random numbers, call before Setup()
+            // Without a seed a headless game uses a fixed one and a game in
+            // a window a different one every run
+            void SetSeed(unsigned int seed);
+
+            // Record the seed and the input of every tick to a file, written
+            // when the game ends. Call before Setup()
+            void SetRecordFile(const std::string &file_name);
+
+            // Play a recording back instead of reading the keyboard, call
+            // before Setup(). Its seed and tick rate replace the ones set so
+            // far, and the game stops when the recording ends or when its
+            // state no longer matches the recorded one (the run then throws)
+            void SetReplayFile(const std::string &file_name);
+
+            // Number of ticks of the recording being played, 0 if none
+            int GetReplayTicks(void);
+
+            // Place at most this many enemies of the waves per tick
+            void SetSpawnBudget(int count);
+
+            // Place enemies of the waves for at most this many microseconds
+            // per tick instead (cannot be recorded or replayed)
+            void SetSpawnTimeBudget(double microseconds);
+
+            // Set the simulation rate of the main loop (ticks per second)
+            void SetTickRate(double rate);
+
+            // Set the most ticks run in one frame to catch up after a slow one
+            void SetMaxCatchUpTicks(int ticks);
+
+            // Set how frames are paced in the window: whether buffer swaps
+            // wait for the display, the most frames per second (0 for no
+            // limit) and the frame rate while the window is in the
+            // background (0 to keep the normal rate)
+            void SetVsync(VsyncMode mode);
+            void SetFrameCap(double fps);
+            void SetIdleRate(double fps);
+
             // Run the game (keep the game active)
+            // The simulation runs in fixed ticks, rendering interpolates
+            // between the last two
             void MainLoop(void); 
 
+            // Run a fixed number of simulation ticks without rendering and
+            // print a benchmark report (requires Init(true))
+            void RunHeadless(int ticks);
+
+            // Write a Chrome trace of the profiled scopes to a file when the
+            // game ends (when built with the profiler)
+            void SetProfileFile(const std::string &file_name);
+
         private:
             // Main window: pointer to the GLFW window structure
             GLFWwindow *window_;
@@ -36,20 +101,97 @@ namespace game {
             // Sprite geometry
             Geometry *sprite_;
 
+            // Worker threads for loading assets
+            ThreadPool workers_;
+
+            // Worker threads for the entity updates of each frame
+            JobSystem jobs_;
+
+            // All textures, shaders and text files used by the game
+            ResourceManager resources_;
+
             // Shader for rendering sprites in the scene
-            Shader sprite_shader_;
+            Shader *sprite_shader_;
+
+            // Camera data, uploaded once per frame for all shaders
+            UniformBuffer camera_buffer_;
+
+            // Batch that draws all sprites of a frame with instancing
+            SpriteBatch sprite_batch_;
+
+            // Shader and chunks of the tiled background, streamed around
+            // the camera by the loading workers
+            Shader *tile_shader_;
+            TileMap tile_map_;
+
+            // Frames recorded by the simulation for the render thread, and
+            // the error that stopped the render thread, if any
+            RenderQueue render_queue_;
+            std::string render_error_;
+
+            // Where the profile is written, empty if only on request
+            std::string profile_file_;
+
+            // Size of the window's framebuffer, updated by ResizeCallback
+            int framebuffer_width_;
+            int framebuffer_height_;
+
+            // Handles of the textures used by the game objects
+            int player_tex_;
+            int invulnerable_tex_;
+            int enemy_tex_;
+            int item_tex_;
+            int explosion_tex_;
+            int background_tex_;
 
-            // References to textures
-#define NUM_TEXTURES 6
-            GLuint tex_[NUM_TEXTURES];
+            // Entities of each kind, stored as arrays of components in a
+            // fixed-capacity pool per kind
+            EntityStore entities_[NUM_ENTITY_KINDS];
 
-            // List of game objects
-            std::vector<GameObject*> game_objects_;
-            std::vector<GameObject*> enemies_;
+            // Well-known entities: the player and the effects shown where an
+            // enemy was destroyed and where the player died
+            EntityHandle player_;
+            EntityHandle explosion_;
+            EntityHandle death_explosion_;
+
+            // Collision broadphase, rebuilt every frame
+            // Between the collision phase and the next flush it holds the
+            // enemies and collectibles by index, so rendering can find the
+            // ones near the camera in it
+            SpatialHash broadphase_;
+            bool broadphase_current_;
+            std::vector<int> render_candidates_;
+
+            // Scratch lists for the collision phase (kept to avoid allocations)
+            // The distances have room for the largest pool
+            std::vector<CollisionPair> pairs_;
+            std::vector<float> distances_;
 
             // Keep track of time
             double current_time_;
 
+            // Random numbers of the world and their seed
+            Random random_;
+            unsigned int seed_;
+            bool seed_set_;
+
+            // Where the input comes from, and where it goes: the keyboard,
+            // the keyboard with every tick recorded, or a recording
+            enum InputMode {
+                INPUT_LIVE = 0,
+                INPUT_RECORD,
+                INPUT_REPLAY
+            };
+            InputMode input_mode_;
+            InputRecording recording_;
+            std::string record_file_;
+
+            // Ticks simulated so far, state hashes compared with the
+            // recording and the first mismatch found, if any
+            int tick_;
+            int hashes_checked_;
+            std::string replay_error_;
+
             // Keep track of an explosion disappearance time
             double end_time_;
 
@@ -68,26 +210,79 @@ namespace game {
             // Tracks if the player is dead
             bool dead;
 
-            // Tracks when to spawn new enemy
-            int spawn;
+            // Brings the waves of enemies in
+            SpawnDirector spawner_;
 
             // Tracks if player is invulnerable or not
             bool invulnerable_;
 
+            // Tracks if the game runs without a window (no input, no rendering)
+            bool headless_;
+
+            // Length of a simulation tick and the most ticks per frame
+            double tick_delta_time_;
+            int max_catch_up_ticks_;
+
+            // Frame pacing: how swaps wait for the display, and the pacer
+            // holding the main loop to the frame cap and idle rate
+            VsyncMode vsync_;
+            FramePacer pacer_;
+
             // Callback for when the window is resized
             static void ResizeCallback(GLFWwindow* window, int width, int height);
 
-            // Set a specific texture
-            void SetTexture(GLuint w, const char *fname);
-
             // Load all textures
             void SetAllTextures();
 
-            // Handle user input
-            void Controls(double delta_time);
+            // Keys of the game held on the keyboard, as InputBits
+            unsigned char PollInput(void);
+
+            // Handle user input, given as InputBits
+            void Controls(double delta_time, unsigned char input);
 
             // Update the game based on user input and simulation
-            void Update(glm::mat4 view_matrix, double delta_time);
+            // A frame runs the phases below in order, each entity is
+            // touched at most once per phase
+            void Update(double delta_time);
+
+            // Spawn phase: bring in the waves of enemies
+            void SpawnEnemies(void);
+
+            // Update phase: move the player, enemies and other objects
+            void UpdateEntities(double delta_time);
+
+            // Collision phase: player against enemies and collectibles
+            void Collide(void);
+
+            // Handle timed events (explosions, invulnerability)
+            void UpdateTimers(void);
+
+            // Removal phase: entities released during the frame leave
+            // their stores
+            void FlushEntities(void);
+
+            // Render phase: record every entity once into a frame for the
+            // render thread, alpha of the way from the previous tick to the
+            // current one
+            void Render(RenderFrame *frame, glm::mat4 view_matrix, float alpha);
+
+            // Point the camera looks at, alpha of the way from the previous
+            // tick to the current one
+            glm::vec3 GetCameraCenter(float alpha);
+
+            // Main function of the render thread: draws the recorded frames
+            // and presents them, owning the OpenGL context meanwhile
+            void RenderLoop(void);
+
+            // Write the profiled scopes of all threads
+            void WriteProfile(void);
+
+            // Hash of everything the simulation depends on
+            uint64_t HashState(void);
+
+            // Save the recording, report how the replay went and throw if it
+            // did not match (when the game ends)
+            void FinishRecording(void);
 
     }; // class Game
 
@@ -6,6 +6,19 @@
 
 namespace game {
 
+    // Vertex attribute locations shared by all geometry and shaders
+    // Shader::Init binds the attribute names below to these locations, so
+    // vertex arrays can be set up once, independently of the shader
+    enum VertexAttribute {
+        ATTRIB_VERTEX = 0,         // "vertex"
+        ATTRIB_COLOR,              // "color"
+        ATTRIB_UV,                 // "uv"
+        ATTRIB_INSTANCE_POSITION,  // "instance_position"
+        ATTRIB_INSTANCE_SCALE,     // "instance_scale"
+        ATTRIB_INSTANCE_REGION,    // "instance_region"
+        NUM_VERTEX_ATTRIBUTES
+    };
+
     // A piece of geometry
     class Geometry {
 
@@ -19,10 +32,14 @@ namespace game {
             // Use the geometry
             virtual void SetGeometry(GLuint shader_program) {};
 
-            // Getter
+            // Getters
             int GetSize(void) { return size_; }
+            GLuint GetVertexArray(void) { return vao_; }
 
         protected:
+            // Vertex array capturing the buffers and attribute layout
+            GLuint vao_;
+
             // Geometry buffers
             GLuint vbo_;
             GLuint ebo_;
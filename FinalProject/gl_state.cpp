@@ -0,0 +1,130 @@
+#include <cstddef>
+
+#include "gl_state.h"
+
+namespace game {
+
+// Value of a cached binding that is not known
+const GLuint unknown_g = 0xFFFFFFFF;
+
+GLuint GLState::program_ = unknown_g;
+GLuint GLState::vertex_array_ = unknown_g;
+GLuint GLState::depth_func_ = unknown_g;
+GLuint GLState::buffers_[NUM_BUFFER_SLOTS] = { unknown_g, unknown_g, unknown_g, unknown_g };
+GLuint GLState::texture_2d_ = unknown_g;
+GLuint GLState::capabilities_[NUM_CAPABILITY_SLOTS] = { unknown_g, unknown_g };
+int GLState::issued_ = 0;
+int GLState::skipped_ = 0;
+
+
+int GLState::GetBufferSlot(GLenum target)
+{
+    switch (target) {
+        case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+        case GL_ELEMENT_ARRAY_BUFFER: return BUFFER_ELEMENT_ARRAY;
+        case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+        case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+        default: return -1;
+    }
+}
+
+
+int GLState::GetCapabilitySlot(GLenum capability)
+{
+    switch (capability) {
+        case GL_DEPTH_TEST: return CAPABILITY_DEPTH_TEST;
+        case GL_BLEND: return CAPABILITY_BLEND;
+        default: return -1;
+    }
+}
+
+
+bool GLState::Change(GLuint *cache, GLuint value)
+{
+    if (cache && *cache == value) {
+        skipped_++;
+        return false;
+    }
+    if (cache) {
+        *cache = value;
+    }
+    issued_++;
+    return true;
+}
+
+
+void GLState::UseProgram(GLuint program)
+{
+    if (Change(&program_, program)) {
+        glUseProgram(program);
+    }
+}
+
+
+void GLState::BindVertexArray(GLuint vao)
+{
+    if (Change(&vertex_array_, vao)) {
+        glBindVertexArray(vao);
+        buffers_[BUFFER_ELEMENT_ARRAY] = unknown_g;
+    }
+}
+
+
+void GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+    int slot = GetBufferSlot(target);
+    if (Change(slot >= 0 ? &buffers_[slot] : NULL, buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+
+void GLState::BindTexture(GLenum target, GLuint texture)
+{
+    if (Change(target == GL_TEXTURE_2D ? &texture_2d_ : NULL, texture)) {
+        glBindTexture(target, texture);
+    }
+}
+
+
+void GLState::Enable(GLenum capability)
+{
+    int slot = GetCapabilitySlot(capability);
+    if (Change(slot >= 0 ? &capabilities_[slot] : NULL, GL_TRUE)) {
+        glEnable(capability);
+    }
+}
+
+
+void GLState::Disable(GLenum capability)
+{
+    int slot = GetCapabilitySlot(capability);
+    if (Change(slot >= 0 ? &capabilities_[slot] : NULL, GL_FALSE)) {
+        glDisable(capability);
+    }
+}
+
+
+void GLState::DepthFunc(GLenum func)
+{
+    if (Change(&depth_func_, func)) {
+        glDepthFunc(func);
+    }
+}
+
+
+void GLState::Invalidate(void)
+{
+    program_ = unknown_g;
+    vertex_array_ = unknown_g;
+    depth_func_ = unknown_g;
+    for (int i = 0; i < NUM_BUFFER_SLOTS; i++) {
+        buffers_[i] = unknown_g;
+    }
+    texture_2d_ = unknown_g;
+    for (int i = 0; i < NUM_CAPABILITY_SLOTS; i++) {
+        capabilities_[i] = unknown_g;
+    }
+}
+
+} // namespace game
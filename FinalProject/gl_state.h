@@ -0,0 +1,90 @@
+#ifndef GL_STATE_H_
+#define GL_STATE_H_
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace game {
+
+    /*
+        GLState is a cache of the OpenGL state that the game changes
+        All rendering code goes through it instead of calling OpenGL
+        directly, so that a change to the state the context is already in
+        is skipped instead of being sent to the driver
+        There is only one OpenGL context, so the state is kept in static
+        members. Only the handful of targets the game uses are cached, each
+        in a fixed slot, changes to other targets always reach the driver
+    */
+    class GLState {
+
+        public:
+            // Bind a shader program
+            static void UseProgram(GLuint program);
+
+            // Bind a vertex array object
+            // The element array buffer is part of the vertex array, so its
+            // cached binding is forgotten
+            static void BindVertexArray(GLuint vao);
+
+            // Bind a buffer to a target (GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, ...)
+            static void BindBuffer(GLenum target, GLuint buffer);
+
+            // Bind a texture to a target of texture unit 0
+            static void BindTexture(GLenum target, GLuint texture);
+
+            // Enable or disable a capability (GL_DEPTH_TEST, GL_BLEND, ...)
+            static void Enable(GLenum capability);
+            static void Disable(GLenum capability);
+
+            // Set the depth comparison function
+            static void DepthFunc(GLenum func);
+
+            // Forget everything, call after the state was changed without
+            // going through this class or after an object was deleted
+            static void Invalidate(void);
+
+            // Number of state changes sent to the driver and skipped because
+            // they were redundant
+            inline static int GetIssued(void) { return issued_; }
+            inline static int GetSkipped(void) { return skipped_; }
+
+        private:
+            // Slots of the cached buffer targets and capabilities
+            enum BufferSlot {
+                BUFFER_ARRAY = 0,
+                BUFFER_ELEMENT_ARRAY,
+                BUFFER_PIXEL_UNPACK,
+                BUFFER_UNIFORM,
+                NUM_BUFFER_SLOTS
+            };
+            enum CapabilitySlot {
+                CAPABILITY_DEPTH_TEST = 0,
+                CAPABILITY_BLEND,
+                NUM_CAPABILITY_SLOTS
+            };
+
+            // Slot of a target or capability, -1 if it is not cached
+            static int GetBufferSlot(GLenum target);
+            static int GetCapabilitySlot(GLenum capability);
+
+            // Check a cached value and update it, returns true if the change
+            // has to be sent to the driver (always without a cached value)
+            static bool Change(GLuint *cache, GLuint value);
+
+            // Cached state (unknown_g where it is not known)
+            static GLuint program_;
+            static GLuint vertex_array_;
+            static GLuint depth_func_;
+            static GLuint buffers_[NUM_BUFFER_SLOTS];
+            static GLuint texture_2d_;
+            static GLuint capabilities_[NUM_CAPABILITY_SLOTS];
+
+            // Statistics
+            static int issued_;
+            static int skipped_;
+
+    }; // class GLState
+
+} // namespace game
+
+#endif // GL_STATE_H_
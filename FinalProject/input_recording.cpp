@@ -0,0 +1,116 @@
+#include <fstream>
+#include <limits.h>
+#include <stdexcept>
+#include <string.h>
+
+#include "input_recording.h"
+
+namespace game {
+
+InputRecording::InputRecording(void)
+{
+    // Initialize variables with default values
+    Init(0, 60.0, 60, 1);
+}
+
+
+void InputRecording::Init(unsigned int seed, double tick_rate, int hash_interval, int spawn_budget)
+{
+    if (hash_interval < 1) {
+        throw(std::runtime_error(std::string("Invalid hash interval ") + std::to_string(hash_interval)));
+    }
+    if (spawn_budget < 1) {
+        throw(std::runtime_error(std::string("Invalid spawn budget ") + std::to_string(spawn_budget)));
+    }
+    seed_ = seed;
+    tick_rate_ = tick_rate;
+    hash_interval_ = hash_interval;
+    spawn_budget_ = spawn_budget;
+    inputs_.clear();
+    hashes_.clear();
+}
+
+
+void InputRecording::Save(const std::string &fname)
+{
+    // Turn the inputs into runs
+    std::vector<RecordingRun> runs;
+    for (int i = 0; i < inputs_.size(); ) {
+        int length = 1;
+        while (i + length < inputs_.size() && inputs_[i + length] == inputs_[i] && length < recording_max_run_g) {
+            length++;
+        }
+        runs.push_back(((RecordingRun) length << 8) | inputs_[i]);
+        i += length;
+    }
+
+    RecordingHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, recording_magic_g, sizeof(header.magic));
+    header.version = recording_version_g;
+    header.seed = seed_;
+    header.hash_interval = hash_interval_;
+    header.tick_rate = tick_rate_;
+    header.num_ticks = (uint32_t) inputs_.size();
+    header.num_runs = (uint32_t) runs.size();
+    header.num_hashes = (uint32_t) hashes_.size();
+    header.spawn_budget = (uint32_t) spawn_budget_;
+
+    std::ofstream f(fname.c_str(), std::ios::binary | std::ios::trunc);
+    if (!f) {
+        throw(std::runtime_error(std::string("Cannot write recording ") + fname));
+    }
+    f.write((const char *) &header, sizeof(header));
+    f.write((const char *) runs.data(), runs.size() * sizeof(RecordingRun));
+    f.write((const char *) hashes_.data(), hashes_.size() * sizeof(uint64_t));
+    if (!f) {
+        throw(std::runtime_error(std::string("Cannot write recording ") + fname));
+    }
+}
+
+
+void InputRecording::Load(const std::string &fname)
+{
+    std::ifstream f(fname.c_str(), std::ios::binary);
+    if (!f) {
+        throw(std::runtime_error(std::string("Cannot open recording ") + fname));
+    }
+
+    // Check the header
+    RecordingHeader header;
+    f.read((char *) &header, sizeof(header));
+    if (!f || memcmp(header.magic, recording_magic_g, 4) != 0 || header.version != recording_version_g ||
+        header.hash_interval < 1 || header.tick_rate <= 0.0 || header.spawn_budget < 1 || header.spawn_budget > INT_MAX) {
+        throw(std::runtime_error(std::string("Invalid recording ") + fname));
+    }
+
+    // Read the runs and the hashes
+    std::vector<RecordingRun> runs(header.num_runs);
+    f.read((char *) runs.data(), runs.size() * sizeof(RecordingRun));
+    hashes_.resize(header.num_hashes);
+    f.read((char *) hashes_.data(), hashes_.size() * sizeof(uint64_t));
+    if (!f) {
+        throw(std::runtime_error(std::string("Truncated recording ") + fname));
+    }
+
+    // Expand the runs into one input per tick
+    inputs_.clear();
+    inputs_.reserve(header.num_ticks);
+    for (int i = 0; i < runs.size(); i++) {
+        uint32_t length = runs[i] >> 8;
+        if (length > header.num_ticks - inputs_.size()) {
+            throw(std::runtime_error(std::string("Invalid recording ") + fname));
+        }
+        inputs_.insert(inputs_.end(), length, (unsigned char) (runs[i] & 0xff));
+    }
+    if (inputs_.size() != header.num_ticks) {
+        throw(std::runtime_error(std::string("Invalid recording ") + fname));
+    }
+
+    seed_ = header.seed;
+    tick_rate_ = header.tick_rate;
+    hash_interval_ = header.hash_interval;
+    spawn_budget_ = (int) header.spawn_budget;
+}
+
+} // namespace game
@@ -0,0 +1,98 @@
+#ifndef INPUT_RECORDING_H_
+#define INPUT_RECORDING_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace game {
+
+    // Keys held during a tick, as bits of one byte
+    enum InputBits {
+        INPUT_UP = 1,
+        INPUT_DOWN = 2,
+        INPUT_RIGHT = 4,
+        INPUT_LEFT = 8,
+        INPUT_QUIT = 16
+    };
+
+    // File layout of a recording: a header, the input of every tick as runs
+    // of equal input, then the state hashes
+    const char recording_magic_g[4] = { 'O', 'C', 'R', 'C' };
+    const uint32_t recording_version_g = 2;
+
+    struct RecordingHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t seed;           // seed of the world's random numbers
+        uint32_t hash_interval;  // ticks between two state hashes
+        double tick_rate;        // ticks per second
+        uint32_t num_ticks;
+        uint32_t num_runs;
+        uint32_t num_hashes;
+        uint32_t spawn_budget;   // enemies spawned per tick at most
+    };
+
+    // A run of ticks with the same input: the input in the low 8 bits and
+    // the number of ticks in the high 24 bits
+    typedef uint32_t RecordingRun;
+    const uint32_t recording_max_run_g = 0xffffff;
+
+    /*
+        InputRecording holds what is needed to play a game again exactly:
+        the random seed of the world, the tick rate, the spawn budget and
+        the input of every tick. A hash of the game state is added every few ticks, so that a
+        replay can tell the moment it stopped matching the recorded game
+
+        Held keys change rarely, so the inputs are stored as runs and an
+        hour of play takes a few kilobytes
+    */
+    class InputRecording {
+
+        public:
+            // Constructor
+            InputRecording(void);
+
+            // Start an empty recording
+            void Init(unsigned int seed, double tick_rate, int hash_interval, int spawn_budget);
+
+            // Add the input of the next tick
+            inline void AddInput(unsigned char input) { inputs_.push_back(input); }
+
+            // Add the hash taken after the last of hash_interval ticks
+            inline void AddHash(uint64_t hash) { hashes_.push_back(hash); }
+
+            // Write the recording to a file, throws if it cannot be written
+            void Save(const std::string &fname);
+
+            // Read a recording from a file, throws if it is missing or invalid
+            void Load(const std::string &fname);
+
+            // Getters
+            inline unsigned int GetSeed(void) { return seed_; }
+            inline double GetTickRate(void) { return tick_rate_; }
+            inline int GetHashInterval(void) { return hash_interval_; }
+            inline int GetSpawnBudget(void) { return spawn_budget_; }
+            inline int GetNumTicks(void) { return (int) inputs_.size(); }
+            inline unsigned char GetInput(int tick) { return inputs_[tick]; }
+            inline int GetNumHashes(void) { return (int) hashes_.size(); }
+            inline uint64_t GetHash(int i) { return hashes_[i]; }
+
+        private:
+            // Setup of the recorded game
+            unsigned int seed_;
+            double tick_rate_;
+            int hash_interval_;
+            int spawn_budget_;
+
+            // Input of every tick, one byte each once loaded
+            std::vector<unsigned char> inputs_;
+
+            // Hashes of the state after every hash_interval ticks
+            std::vector<uint64_t> hashes_;
+
+    }; // class InputRecording
+
+} // namespace game
+
+#endif // INPUT_RECORDING_H_
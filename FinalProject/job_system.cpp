@@ -0,0 +1,188 @@
+#include "profiler.h"
+#include "job_system.h"
+
+namespace game {
+
+// Jobs a worker queue can hold, a full queue runs further jobs right away
+const int job_queue_capacity_g = 256;
+
+// Worker of the current thread: the job system it belongs to and its queue
+static thread_local JobSystem *worker_owner_g = NULL;
+static thread_local int worker_index_g = 0;
+
+
+JobSystem::JobSystem(void)
+{
+    // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    queued_ = 0;
+    num_jobs_ = 0;
+    num_stolen_ = 0;
+    stop_ = false;
+}
+
+
+JobSystem::~JobSystem()
+{
+    // Wake up the workers and let them exit
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    work_ready_.notify_all();
+    for (int i = 0; i < threads_.size(); i++) {
+        threads_[i].join();
+    }
+    for (int i = 0; i < queues_.size(); i++) {
+        delete queues_[i];
+    }
+}
+
+
+void JobSystem::Init(int num_workers)
+{
+    if (num_workers <= 0) {
+        num_workers = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+
+    // One queue per worker, allocated once
+    for (int i = 0; i < num_workers; i++) {
+        WorkQueue *queue = new WorkQueue();
+        queue->jobs.resize(job_queue_capacity_g);
+        queue->front = 0;
+        queue->size = 0;
+        queues_.push_back(queue);
+    }
+
+    // The calling thread is worker 0, the others get their own thread
+    worker_owner_g = this;
+    worker_index_g = 0;
+    for (int i = 1; i < num_workers; i++) {
+        threads_.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+    }
+}
+
+
+int JobSystem::GetWorkerIndex(void)
+{
+    // Threads that are not workers share the first queue
+    return worker_owner_g == this ? worker_index_g : 0;
+}
+
+
+void JobSystem::Push(Job *jobs, int count)
+{
+    WorkQueue *queue = queues_[GetWorkerIndex()];
+    int pushed = 0;
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        int capacity = (int) queue->jobs.size();
+        while (pushed < count && queue->size < capacity) {
+            queue->jobs[(queue->front + queue->size) % capacity] = jobs[pushed++];
+            queue->size++;
+        }
+    }
+
+    // Wake up the idle workers
+    if (pushed > 0) {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            queued_ += pushed;
+        }
+        work_ready_.notify_all();
+    }
+
+    // Run what did not fit
+    for (int i = pushed; i < count; i++) {
+        jobs[i].function(jobs[i].data, jobs[i].begin, jobs[i].end);
+        num_jobs_++;
+        (*jobs[i].remaining)--;
+    }
+}
+
+
+bool JobSystem::Pop(int worker, Job &job)
+{
+    // Own queue first, newest job
+    {
+        WorkQueue *queue = queues_[worker];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->size > 0) {
+            queue->size--;
+            job = queue->jobs[(queue->front + queue->size) % queue->jobs.size()];
+            queued_--;
+            return true;
+        }
+    }
+
+    // Then steal the oldest job of another worker, starting with the next
+    // one so that thieves spread over the queues
+    int num_queues = (int) queues_.size();
+    for (int k = 1; k < num_queues; k++) {
+        WorkQueue *queue = queues_[(worker + k) % num_queues];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->size > 0) {
+            job = queue->jobs[queue->front];
+            queue->front = (queue->front + 1) % queue->jobs.size();
+            queue->size--;
+            queued_--;
+            num_stolen_++;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool JobSystem::RunOne(int worker)
+{
+    Job job;
+    if (queued_ == 0 || !Pop(worker, job)) {
+        return false;
+    }
+    {
+        PROFILE_SCOPE("Job");
+        job.function(job.data, job.begin, job.end);
+    }
+    num_jobs_++;
+    (*job.remaining)--;
+    return true;
+}
+
+
+void JobSystem::WaitFor(std::atomic<int> &remaining)
+{
+    // Jobs of other threads can keep this one busy, but it only returns
+    // once its own are done
+    int worker = GetWorkerIndex();
+    while (remaining > 0) {
+        if (!RunOne(worker)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+void JobSystem::WorkerLoop(int worker)
+{
+    worker_owner_g = this;
+    worker_index_g = worker;
+    PROFILE_THREAD("job worker");
+
+    while (true) {
+        // Run jobs while there are any
+        if (RunOne(worker)) {
+            continue;
+        }
+
+        // Sleep until more jobs are queued
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        work_ready_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_) {
+            return;
+        }
+    }
+}
+
+} // namespace game
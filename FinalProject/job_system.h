@@ -0,0 +1,170 @@
+#ifndef JOB_SYSTEM_H_
+#define JOB_SYSTEM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace game {
+
+    // A piece of work: a function over a range of indices
+    // The data pointer is passed back to the function untouched
+    struct Job {
+        void (*function)(void *data, int begin, int end);
+        void *data;
+        int begin;
+        int end;
+        std::atomic<int> *remaining;
+    };
+
+    /*
+        JobSystem runs short jobs, such as the chunks of a system update,
+        on one worker thread per core. Every worker has its own queue: it
+        takes the jobs it queued itself from the back (the most recent ones,
+        still in its cache) and, when it runs out, steals from the front of
+        the other queues, so the load evens out without a shared queue that
+        every thread contends for. The thread that waits for its jobs runs
+        jobs too, so it counts as one of the workers.
+
+        Unlike ThreadPool, which is meant for long tasks such as decoding
+        files, nothing is allocated to queue a job, so it can be used every
+        frame
+    */
+    class JobSystem {
+
+        public:
+            // Constructor and destructor
+            JobSystem(void);
+            ~JobSystem();
+
+            // Start the workers, including the calling thread
+            // (0 uses one per core, 1 runs everything on the calling thread)
+            void Init(int num_workers = 0);
+
+            // Run body(chunk_begin, chunk_end) over [begin, end) in chunks of
+            // at least grain indices, spread over the workers, and return
+            // once every chunk is done. Chunks cover disjoint ranges, so
+            // writes to per-index outputs need no synchronization
+            template <typename F>
+            void ParallelFor(int begin, int end, int grain, const F &body);
+
+            // Getters
+            inline int GetNumWorkers(void) { return (int) queues_.size(); }
+            inline long long GetNumJobs(void) { return num_jobs_; }
+            inline long long GetNumStolen(void) { return num_stolen_; }
+
+        private:
+            // Jobs queued by one worker, in a fixed ring buffer
+            // The owner works at the back, thieves take from the front
+            struct WorkQueue {
+                std::mutex mutex;
+                std::vector<Job> jobs;
+                int front;
+                int size;
+            };
+
+            // Queue of each worker, the calling thread of Init owns the first
+            std::vector<WorkQueue *> queues_;
+
+            // Worker threads (one fewer than queues)
+            std::vector<std::thread> threads_;
+
+            // Number of jobs waiting in all queues
+            std::atomic<int> queued_;
+
+            // Statistics: jobs run and jobs run by a thread that did not queue them
+            std::atomic<long long> num_jobs_;
+            std::atomic<long long> num_stolen_;
+
+            // Tells the workers to exit
+            bool stop_;
+
+            // Idle workers sleep until jobs are queued
+            std::mutex sleep_mutex_;
+            std::condition_variable work_ready_;
+
+            // Queue jobs on the calling thread's queue
+            void Push(Job *jobs, int count);
+
+            // Take a job from the worker's own queue, or steal one
+            bool Pop(int worker, Job &job);
+
+            // Run one job if there is any, returns false if all queues are empty
+            bool RunOne(int worker);
+
+            // Run jobs until the counter reaches zero
+            void WaitFor(std::atomic<int> &remaining);
+
+            // Queue index of the calling thread
+            int GetWorkerIndex(void);
+
+            // Main function of a worker thread
+            void WorkerLoop(int worker);
+
+            // Calls the body of a ParallelFor on one chunk
+            template <typename F>
+            static void RunChunk(void *data, int begin, int end);
+
+    }; // class JobSystem
+
+
+    template <typename F>
+    void JobSystem::RunChunk(void *data, int begin, int end)
+    {
+
+        (*(const F *) data)(begin, end);
+    }
+
+
+    template <typename F>
+    void JobSystem::ParallelFor(int begin, int end, int grain, const F &body)
+    {
+        int count = end - begin;
+        if (count <= 0) {
+            return;
+        }
+
+        // Split the range into about four chunks per worker, so that
+        // stealing can even out chunks that take longer
+        int num_chunks = GetNumWorkers() * 4;
+        int chunk = std::max(grain, (count + num_chunks - 1) / num_chunks);
+        num_chunks = (count + chunk - 1) / chunk;
+
+        // A single chunk runs right away
+        if (num_chunks <= 1 || GetNumWorkers() <= 1) {
+            body(begin, end);
+            return;
+        }
+
+        // Queue all chunks but the first, which the calling thread runs
+        // while the others get picked up
+        const int max_batch = 64;
+        std::atomic<int> remaining(0);
+        Job batch[max_batch];
+        int queued = 0;
+        for (int c = 1; c < num_chunks; c++) {
+            Job &job = batch[queued++];
+            job.function = &RunChunk<F>;
+            job.data = (void *) &body;
+            job.begin = begin + c * chunk;
+            job.end = std::min(end, job.begin + chunk);
+            job.remaining = &remaining;
+            if (queued == max_batch || c == num_chunks - 1) {
+                remaining += queued;
+                Push(batch, queued);
+                queued = 0;
+            }
+        }
+        body(begin, std::min(end, begin + chunk));
+        num_jobs_++;
+
+        // Help with the remaining chunks (or anything else) until ours are done
+        WaitFor(remaining);
+    }
+
+} // namespace game
+
+#endif // JOB_SYSTEM_H_
@@ -8,27 +8,160 @@
 
 #include <iostream>
 #include <exception>
+#include <string>
+#include <stdlib.h>
 #include "game.h"
+#include "simd_kernels.h"
 
 // Macro for printing exceptions
 #define PrintException(exception_object)\
     std::cerr << exception_object.what() << std::endl
 
+// Default length of the headless benchmark
+const int headless_ticks_g = 10000;
+
 // Main function that builds and runs the game
-int main(void){
+// Pass "--headless [ticks]" to run the simulation without a window (a
+// recording is played to its end by default)
+// Pass "--simd scalar|sse2|avx2" to choose the instruction set of the
+// simulation kernels (the fastest supported one by default)
+// Pass "--threads <n>" to set the number of threads that update the
+// entities (one per core by default)
+// Pass "--tick-rate <hz>" and "--max-catch-up <ticks>" to set the fixed
+// simulation rate
+// Pass "--spawn-budget <enemies>" or "--spawn-budget-us <microseconds>" to
+// limit how much of a wave of enemies is placed in one tick
+// Pass "--seed <n>" to seed the random numbers of the game
+// Pass "--record <file>" to save the seed and the input of every tick, and
+// "--replay <file>" to play such a file back, checking that the game
+// goes the same way
+// Pass "--vsync on|off|adaptive", "--fps-cap <hz>" and "--idle-fps <hz>" to
+// pace the frames of the window (vsync on, no cap and 15 frames per second
+// in the background by default)
+// Pass "--profile <file>" to write a Chrome trace of the run to a file
+// when it ends (press P in game to write profile.json at any time)
+int main(int argc, char **argv){
     game::Game the_game;
 
+    // Parse command line options
+    bool headless = false;
+    int ticks = -1;
+    int threads = 0;
+    double tick_rate = 0.0;
+    int max_catch_up = 0;
+    std::string profile_file;
+    std::string record_file;
+    std::string replay_file;
+    int vsync = -1;
+    double fps_cap = -1.0;
+    double idle_fps = -1.0;
+    int spawn_budget = 0;
+    double spawn_budget_us = 0.0;
+    bool seed_set = false;
+    unsigned int seed = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                ticks = atoi(argv[++i]);
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (arg == "--tick-rate" && i + 1 < argc) {
+            tick_rate = atof(argv[++i]);
+        } else if (arg == "--max-catch-up" && i + 1 < argc) {
+            max_catch_up = atoi(argv[++i]);
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profile_file = argv[++i];
+        } else if (arg == "--vsync" && i + 1 < argc) {
+            std::string name = argv[++i];
+            vsync = 0;
+            while (vsync < game::NUM_VSYNC_MODES && name != game::GetVsyncModeName((game::VsyncMode) vsync)) {
+                vsync++;
+            }
+            if (vsync == game::NUM_VSYNC_MODES) {
+                std::cerr << "Unknown vsync mode " << name << ", using on" << std::endl;
+                vsync = game::VSYNC_ON;
+            }
+        } else if (arg == "--fps-cap" && i + 1 < argc) {
+            fps_cap = atof(argv[++i]);
+        } else if (arg == "--idle-fps" && i + 1 < argc) {
+            idle_fps = atof(argv[++i]);
+        } else if (arg == "--spawn-budget" && i + 1 < argc) {
+            spawn_budget = atoi(argv[++i]);
+        } else if (arg == "--spawn-budget-us" && i + 1 < argc) {
+            spawn_budget_us = atof(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+            seed_set = true;
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_file = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else if (arg == "--simd" && i + 1 < argc) {
+            std::string name = argv[++i];
+            int level = 0;
+            while (level < game::NUM_SIMD_LEVELS && name != game::GetSimdLevelName((game::SimdLevel) level)) {
+                level++;
+            }
+            if (level == game::NUM_SIMD_LEVELS || !game::SetSimdLevel((game::SimdLevel) level)) {
+                std::cerr << "Instruction set " << name << " is not supported, using " << game::GetSimdLevelName(game::GetSimdLevel()) << std::endl;
+            }
+        }
+    }
+
     try {
         // Initialize graphics libraries and main window
-        the_game.Init();
+        the_game.Init(headless, threads);
+        // Set up the simulation, a recording replaces the seed and tick rate
+        if (tick_rate > 0.0) {
+            the_game.SetTickRate(tick_rate);
+        }
+        if (max_catch_up > 0) {
+            the_game.SetMaxCatchUpTicks(max_catch_up);
+        }
+        if (vsync >= 0) {
+            the_game.SetVsync((game::VsyncMode) vsync);
+        }
+        if (fps_cap >= 0.0) {
+            the_game.SetFrameCap(fps_cap);
+        }
+        if (idle_fps >= 0.0) {
+            the_game.SetIdleRate(idle_fps);
+        }
+        if (spawn_budget > 0) {
+            the_game.SetSpawnBudget(spawn_budget);
+        }
+        if (spawn_budget_us > 0.0) {
+            the_game.SetSpawnTimeBudget(spawn_budget_us);
+        }
+        if (seed_set) {
+            the_game.SetSeed(seed);
+        }
+        if (!record_file.empty()) {
+            the_game.SetRecordFile(record_file);
+        }
+        if (!replay_file.empty()) {
+            the_game.SetReplayFile(replay_file);
+        }
         // Setup the game (scene, game objects, etc.)
         the_game.Setup();
         // Run the game
-        the_game.MainLoop();
+        the_game.SetProfileFile(profile_file);
+        if (headless) {
+            if (ticks < 0) {
+                ticks = replay_file.empty() ? headless_ticks_g : the_game.GetReplayTicks();
+            }
+            the_game.RunHeadless(ticks);
+        } else {
+            the_game.MainLoop();
+        }
     }
     catch (std::exception &e){
         // Catch and print any errors
         PrintException(e);
+        return 1;
     }
 
     return 0;
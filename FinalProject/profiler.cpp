@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "profiler.h"
+
+namespace game {
+
+// Scopes kept per thread (a power of two), older ones are overwritten
+const int profiler_ring_size_g = 1 << 16;
+
+// GPU queries in flight at most, later GPU scopes are dropped until the
+// oldest results come back
+const int profiler_gpu_queries_g = 32;
+
+// A recorded scope
+struct ProfileEvent {
+    const char *name;
+    double begin;
+    double end;
+};
+
+// Slot of a ring, read by the trace writer while its thread may overwrite
+// it, so the fields are atomics (relaxed, they compile to plain moves)
+struct ProfileSlot {
+    std::atomic<const char *> name;
+    std::atomic<double> begin;
+    std::atomic<double> end;
+};
+
+// Ring buffer of the scopes of one thread
+// Only its thread writes to it; head counts every event ever written, so
+// a reader can tell which slots were overwritten while it was copying them
+struct ProfileThread {
+    std::string name;
+    int id;
+    std::unique_ptr<ProfileSlot[]> events;
+    std::atomic<unsigned long long> head;
+};
+
+// Time origin of the trace
+static const std::chrono::steady_clock::time_point profiler_start_g = std::chrono::steady_clock::now();
+
+// Whether scopes are recorded
+static std::atomic<bool> profiler_enabled_g(true);
+
+// Every thread that recorded something, kept until exit so that the
+// scopes of finished threads still show up in the trace
+static std::mutex profiler_threads_mutex_g;
+static std::vector<std::unique_ptr<ProfileThread> > profiler_threads_g;
+
+// Ring of the calling thread
+static thread_local ProfileThread *profiler_thread_g = NULL;
+
+// Queries of the GPU scopes, only used by the thread that owns the context
+struct GpuQuery {
+    GLuint query;
+    const char *name;
+    double begin;
+};
+static GpuQuery gpu_queries_g[profiler_gpu_queries_g];
+static bool gpu_queries_created_g = false;
+static unsigned long long gpu_issued_g = 0;
+static unsigned long long gpu_collected_g = 0;
+static bool gpu_scope_open_g = false;
+static ProfileThread *gpu_thread_g = NULL;
+
+
+// Create a ring and add it to the list
+static ProfileThread *AddProfileThread(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(profiler_threads_mutex_g);
+    ProfileThread *thread = new ProfileThread();
+    thread->name = name;
+    thread->id = (int) profiler_threads_g.size() + 1;
+    thread->events.reset(new ProfileSlot[profiler_ring_size_g]);
+    thread->head = 0;
+    profiler_threads_g.push_back(std::unique_ptr<ProfileThread>(thread));
+    return thread;
+}
+
+
+// Ring of the calling thread, created on first use
+static ProfileThread *GetProfileThread(void)
+{
+    if (!profiler_thread_g) {
+        profiler_thread_g = AddProfileThread("thread");
+    }
+    return profiler_thread_g;
+}
+
+
+// Add an event to a ring, only from the thread that owns it
+// The fence orders the slot stores after the previous head store: a reader
+// that sees any of them also sees head at index or later (see
+// WriteChromeTrace)
+static inline void PushEvent(ProfileThread *thread, const char *name, double begin, double end)
+{
+    unsigned long long index = thread->head.load(std::memory_order_relaxed);
+    ProfileSlot &event = thread->events[index & (profiler_ring_size_g - 1)];
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    thread->head.store(index + 1, std::memory_order_release);
+}
+
+
+// Write a string as a JSON string
+static void WriteJsonString(std::ofstream &out, const std::string &s)
+{
+    out << '"';
+    for (int i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') {
+            out << '\\';
+        }
+        out << s[i];
+    }
+    out << '"';
+}
+
+
+void Profiler::SetEnabled(bool enabled)
+{
+
+    profiler_enabled_g.store(enabled, std::memory_order_relaxed);
+}
+
+
+bool Profiler::IsEnabled(void)
+{
+
+    return profiler_enabled_g.load(std::memory_order_relaxed);
+}
+
+
+void Profiler::SetThreadName(const char *name)
+{
+    // Threads name themselves before recording, so the name is only set
+    // while no reader looks at it
+    ProfileThread *thread = GetProfileThread();
+    std::lock_guard<std::mutex> lock(profiler_threads_mutex_g);
+    thread->name = name;
+}
+
+
+double Profiler::Now(void)
+{
+
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - profiler_start_g).count();
+}
+
+
+void Profiler::Record(const char *name, double begin, double end)
+{
+
+    PushEvent(GetProfileThread(), name, begin, end);
+}
+
+
+int Profiler::WriteChromeTrace(const std::string &file_name)
+{
+    std::ofstream out(file_name.c_str());
+    if (!out) {
+        throw(std::runtime_error(std::string("Could not write the profile to ") + file_name));
+    }
+
+    // Trace event format, durations in microseconds
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    int num_events = 0;
+    std::vector<ProfileEvent> events;
+    std::lock_guard<std::mutex> lock(profiler_threads_mutex_g);
+    for (int t = 0; t < profiler_threads_g.size(); t++) {
+        ProfileThread *thread = profiler_threads_g[t].get();
+
+        // Thread name
+        if (t > 0) {
+            out << ",\n";
+        }
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id << ",\"args\":{\"name\":";
+        WriteJsonString(out, thread->name);
+        out << "}}";
+
+        // Copy the ring while its thread keeps writing, then drop the
+        // events that may have been overwritten during the copy
+        // The fence makes head at least as new as any slot that was read,
+        // and the event at new_head may be half written over its slot
+        unsigned long long head = thread->head.load(std::memory_order_acquire);
+        unsigned long long first = head > profiler_ring_size_g ? head - profiler_ring_size_g : 0;
+        events.clear();
+        for (unsigned long long i = first; i < head; i++) {
+            ProfileSlot &slot = thread->events[i & (profiler_ring_size_g - 1)];
+            ProfileEvent event;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.begin = slot.begin.load(std::memory_order_relaxed);
+            event.end = slot.end.load(std::memory_order_relaxed);
+            events.push_back(event);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned long long new_head = thread->head.load(std::memory_order_relaxed) + 1;
+        unsigned long long valid = new_head > profiler_ring_size_g ? new_head - profiler_ring_size_g : 0;
+        int skip = valid > first ? (int) std::min<unsigned long long>(valid - first, events.size()) : 0;
+
+        for (int i = skip; i < events.size(); i++) {
+            out << ",\n{\"name\":";
+            WriteJsonString(out, events[i].name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+                << ",\"ts\":" << events[i].begin << ",\"dur\":" << events[i].end - events[i].begin << "}";
+            num_events++;
+        }
+    }
+    out << "\n]}\n";
+    return num_events;
+}
+
+
+void Profiler::BeginGpuScope(const char *name)
+{
+    gpu_scope_open_g = false;
+    if (!IsEnabled() || !(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)) {
+        return;
+    }
+
+    // Create the queries with the first scope, on the context's thread
+    if (!gpu_queries_created_g) {
+        for (int i = 0; i < profiler_gpu_queries_g; i++) {
+            glGenQueries(1, &gpu_queries_g[i].query);
+        }
+        gpu_queries_created_g = true;
+        if (!gpu_thread_g) {
+            gpu_thread_g = AddProfileThread("GPU");
+        }
+    }
+
+    // Drop the scope if every query is still waiting for its result
+    if (gpu_issued_g - gpu_collected_g == profiler_gpu_queries_g) {
+        return;
+    }
+    GpuQuery &query = gpu_queries_g[gpu_issued_g % profiler_gpu_queries_g];
+    query.name = name;
+    query.begin = Now();
+    glBeginQuery(GL_TIME_ELAPSED, query.query);
+    gpu_scope_open_g = true;
+}
+
+
+void Profiler::EndGpuScope(void)
+{
+    if (!gpu_scope_open_g) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    gpu_issued_g++;
+    gpu_scope_open_g = false;
+}
+
+
+void Profiler::CollectGpuScopes(void)
+{
+    // Results come back in order, stop at the first one not ready yet
+    while (gpu_collected_g < gpu_issued_g) {
+        GpuQuery &query = gpu_queries_g[gpu_collected_g % profiler_gpu_queries_g];
+        GLint available = 0;
+        glGetQueryObjectiv(query.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        // The GPU time is placed where the CPU issued the commands
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &elapsed);
+        PushEvent(gpu_thread_g, query.name, query.begin, query.begin + elapsed / 1000.0);
+        gpu_collected_g++;
+    }
+}
+
+
+void Profiler::ReleaseGpuScopes(void)
+{
+    if (!gpu_queries_created_g) {
+        return;
+    }
+    for (int i = 0; i < profiler_gpu_queries_g; i++) {
+        glDeleteQueries(1, &gpu_queries_g[i].query);
+    }
+    gpu_queries_created_g = false;
+    gpu_issued_g = 0;
+    gpu_collected_g = 0;
+}
+
+} // namespace game
@@ -0,0 +1,100 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <string>
+
+// Profiling macros, they compile to nothing unless USE_PROFILER is defined
+// (see the USE_PROFILER option in CMakeLists.txt)
+//
+//   PROFILE_SCOPE("name")      time the rest of the enclosing block on the CPU
+//   PROFILE_GPU_SCOPE("name")  time the GL commands of the rest of the block
+//                              on the GPU (render thread only, must not nest)
+//   PROFILE_THREAD("name")     name the calling thread in the trace
+//
+// Scope names must be string literals (or otherwise live for the whole run),
+// thread names are copied
+#ifdef USE_PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) game::ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) game::GpuProfileScope PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(name)
+#define PROFILE_THREAD(name) game::Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_THREAD(name)
+#endif
+
+namespace game {
+
+    /*
+        Profiler records timed scopes from every thread and writes them as a
+        Chrome trace (load the file in chrome://tracing or Perfetto)
+
+        Each thread writes its scopes into its own fixed ring buffer without
+        locking, so timing a scope costs two clock reads and a store. When a
+        ring is full the oldest scopes are overwritten: a trace always holds
+        the most recent events of each thread. GPU scopes use GL_TIME_ELAPSED
+        queries from a small pool; their results are read back frames later,
+        once they are available, so timing never stalls the pipeline
+    */
+    class Profiler {
+
+        public:
+            // Turn recording on or off at run time (on by default)
+            static void SetEnabled(bool enabled);
+            static bool IsEnabled(void);
+
+            // Name of the calling thread in the trace
+            static void SetThreadName(const char *name);
+
+            // Record a scope of the calling thread, times in microseconds
+            // since the profiler started
+            static void Record(const char *name, double begin, double end);
+
+            // Microseconds since the profiler started
+            static double Now(void);
+
+            // Write the recorded scopes of all threads as a Chrome trace
+            // Can be called at any time, the threads keep recording
+            // Returns the number of events written
+            static int WriteChromeTrace(const std::string &file_name);
+
+            // GPU timing, on the thread that owns the OpenGL context
+            // Collect reads back the queries that have finished, call it
+            // once per frame. Release deletes the queries before the
+            // context goes away
+            static void BeginGpuScope(const char *name);
+            static void EndGpuScope(void);
+            static void CollectGpuScopes(void);
+            static void ReleaseGpuScopes(void);
+
+    }; // class Profiler
+
+
+    // Times the enclosing block (see PROFILE_SCOPE)
+    class ProfileScope {
+
+        public:
+            inline ProfileScope(const char *name) : name_(name), begin_(Profiler::IsEnabled() ? Profiler::Now() : -1.0) {}
+            inline ~ProfileScope() { if (begin_ >= 0.0) Profiler::Record(name_, begin_, Profiler::Now()); }
+
+        private:
+            const char *name_;
+            double begin_;
+
+    }; // class ProfileScope
+
+
+    // Times the GL commands of the enclosing block (see PROFILE_GPU_SCOPE)
+    class GpuProfileScope {
+
+        public:
+            inline GpuProfileScope(const char *name) { Profiler::BeginGpuScope(name); }
+            inline ~GpuProfileScope() { Profiler::EndGpuScope(); }
+
+    }; // class GpuProfileScope
+
+} // namespace game
+
+#endif // PROFILER_H_
@@ -0,0 +1,40 @@
+#include "random.h"
+
+namespace game {
+
+Random::Random(void)
+{
+    // Initialize variables with default values
+    Seed(0);
+}
+
+
+void Random::Seed(unsigned int seed)
+{
+    // Spread the bits of the seed over the state (splitmix64), so that
+    // close seeds start far apart and no seed gives the zero state
+    uint64_t z = (uint64_t) seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    state_ = z ? z : 0x9e3779b97f4a7c15ull;
+}
+
+
+unsigned int Random::Next(void)
+{
+    // xorshift64*, the high bits of the product are the best ones
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return (unsigned int) ((state_ * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+
+float Random::Float(void)
+{
+    // As many bits as a float holds exactly
+    return (Next() >> 8) * (1.0f / 16777216.0f);
+}
+
+} // namespace game
@@ -0,0 +1,37 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <stdint.h>
+
+namespace game {
+
+    /*
+        Random is a small pseudo-random number generator owned by a world
+        Unlike rand(), its sequence depends only on its seed, not on the
+        platform or on whatever else drew numbers, so a world seeded the
+        same way plays out the same way
+    */
+    class Random {
+
+        public:
+            // Constructor, seeded with 0
+            Random(void);
+
+            // Restart the sequence of a seed
+            void Seed(unsigned int seed);
+
+            // Next 32 random bits
+            unsigned int Next(void);
+
+            // Random number in [0, 1)
+            float Float(void);
+
+        private:
+            // State of the generator, never 0
+            uint64_t state_;
+
+    }; // class Random
+
+} // namespace game
+
+#endif // RANDOM_H_
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include "render_queue.h"
+
+namespace game {
+
+ViewRect GetViewRect(const glm::mat4 &view_matrix)
+{
+    // Bring the corners of clip space back into the world
+    glm::mat4 inverse = glm::inverse(view_matrix);
+    ViewRect view;
+    for (int c = 0; c < 4; c++) {
+        glm::vec4 corner = inverse * glm::vec4((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, 0.0f, 1.0f);
+        float x = corner.x / corner.w;
+        float y = corner.y / corner.w;
+        view.min_x = c ? std::min(view.min_x, x) : x;
+        view.min_y = c ? std::min(view.min_y, y) : y;
+        view.max_x = c ? std::max(view.max_x, x) : x;
+        view.max_y = c ? std::max(view.max_y, y) : y;
+    }
+    return view;
+}
+
+
+RenderQueue::RenderQueue(void)
+{
+    // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    read_index_ = 0;
+    num_filled_ = 0;
+    closed_ = false;
+    num_frames_ = 0;
+    write_wait_ = 0.0;
+    read_wait_ = 0.0;
+}
+
+
+void RenderQueue::Init(int num_buffers)
+{
+    // One frame being drawn and at least one being recorded
+    if (num_buffers < 2) {
+        throw(std::runtime_error(std::string("A render queue needs at least two buffers, got ") + std::to_string(num_buffers)));
+    }
+    frames_.resize(num_buffers);
+}
+
+
+RenderFrame *RenderQueue::BeginWrite(void)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Wait for the renderer to give back a frame if all are in use
+    auto start = std::chrono::steady_clock::now();
+    frame_free_.wait(lock, [this] { return closed_ || num_filled_ < (int) frames_.size(); });
+    write_wait_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (closed_) {
+        return NULL;
+    }
+
+    // The next frame after the recorded ones
+    RenderFrame *frame = &frames_[(read_index_ + num_filled_) % frames_.size()];
+    frame->sprites.clear();
+    frame->num_culled = 0;
+    return frame;
+}
+
+
+void RenderQueue::EndWrite(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        num_filled_++;
+        num_frames_++;
+    }
+    frame_ready_.notify_one();
+}
+
+
+RenderFrame *RenderQueue::BeginRead(void)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Wait for the simulation to record a frame
+    auto start = std::chrono::steady_clock::now();
+    frame_ready_.wait(lock, [this] { return closed_ || num_filled_ > 0; });
+    read_wait_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (closed_) {
+        return NULL;
+    }
+    return &frames_[read_index_];
+}
+
+
+void RenderQueue::EndRead(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        read_index_ = (read_index_ + 1) % frames_.size();
+        num_filled_--;
+    }
+    frame_free_.notify_one();
+}
+
+
+void RenderQueue::Close(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    frame_ready_.notify_all();
+    frame_free_.notify_all();
+}
+
+} // namespace game
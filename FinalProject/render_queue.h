@@ -0,0 +1,110 @@
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "sprite_batch.h"
+
+namespace game {
+
+    // Part of the world shown by a camera, as an axis-aligned rectangle
+    struct ViewRect {
+        float min_x;
+        float min_y;
+        float max_x;
+        float max_y;
+    };
+
+    // Rectangle that a view matrix maps onto the screen, that is the world
+    // bounds of the corners of clip space
+    ViewRect GetViewRect(const glm::mat4 &view_matrix);
+
+    // Everything the renderer needs to draw one frame, recorded by the
+    // simulation: the camera, the viewport and the sprite instances
+    struct RenderFrame {
+        glm::mat4 view_matrix;
+        ViewRect view;
+        int viewport_width;
+        int viewport_height;
+        std::vector<SpriteInstance> sprites;
+
+        // Sprites left out because they were outside the view
+        int num_culled;
+
+        // Queue a sprite showing the given atlas region
+        inline void AddSprite(const glm::vec3 &position, float scale, int region)
+        {
+            SpriteInstance instance;
+            instance.position = position;
+            instance.scale = scale;
+            instance.region = (float) region;
+            sprites.push_back(instance);
+        }
+    };
+
+    /*
+        RenderQueue hands frames from the simulation thread to the render
+        thread through a small ring of frame buffers (two or three). The
+        simulation records frame N+1 into a free buffer while the renderer
+        draws frame N from another one; each side only waits when the other
+        one is a whole ring behind. The buffers are reused, so once they
+        have grown to the size of a frame nothing is allocated
+    */
+    class RenderQueue {
+
+        public:
+            // Constructor
+            RenderQueue(void);
+
+            // Allocate the frame buffers
+            void Init(int num_buffers);
+
+            // Simulation side: get a free frame to record into (waits until
+            // one is free), then pass it on. Returns NULL once closed
+            RenderFrame *BeginWrite(void);
+            void EndWrite(void);
+
+            // Render side: get the oldest recorded frame (waits until one is
+            // ready), then give it back. Returns NULL once closed
+            RenderFrame *BeginRead(void);
+            void EndRead(void);
+
+            // Stop both sides, wakes up whoever is waiting
+            void Close(void);
+
+            // Statistics: frames passed through and time each side spent
+            // waiting for the other, in seconds
+            inline int GetNumFrames(void) { return num_frames_; }
+            inline double GetWriteWait(void) { return write_wait_; }
+            inline double GetReadWait(void) { return read_wait_; }
+
+        private:
+            // Ring of frames
+            std::vector<RenderFrame> frames_;
+
+            // Oldest frame not given back by the renderer, and the number of
+            // frames recorded and not given back yet
+            int read_index_;
+            int num_filled_;
+
+            // Set once the queue is closed
+            bool closed_;
+
+            // Statistics
+            int num_frames_;
+            double write_wait_;
+            double read_wait_;
+
+            // Protects the ring, signals recorded and returned frames
+            std::mutex mutex_;
+            std::condition_variable frame_ready_;
+            std::condition_variable frame_free_;
+
+    }; // class RenderQueue
+
+} // namespace game
+
+#endif // RENDER_QUEUE_H_
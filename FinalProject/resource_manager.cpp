@@ -0,0 +1,245 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include "file_utils.h"
+#include "resource_manager.h"
+
+namespace game {
+
+// Names of the asset types, in the order of the ResourceType enum
+const char *resource_type_names_g[NUM_RESOURCE_TYPES] = {
+    "texture",
+    "shader",
+    "text"
+};
+
+
+ResourceManager::ResourceManager(void)
+{
+    // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    headless_ = false;
+    pool_ = NULL;
+}
+
+
+ResourceManager::~ResourceManager()
+{
+}
+
+
+void ResourceManager::Init(const std::string &directory, bool headless, ThreadPool *pool)
+{
+    directory_ = directory;
+    headless_ = headless;
+    pool_ = pool;
+}
+
+
+bool ResourceManager::OpenPack(const std::string &file)
+{
+    if (file.empty() || !pack_.Open(file)) {
+        std::cout << "No asset pack, loading loose files from " << directory_ << std::endl;
+        return false;
+    }
+    std::cout << "Mapped asset pack " << file << " (" << pack_.GetSize() << " bytes)" << std::endl;
+    return true;
+}
+
+
+int ResourceManager::Find(ResourceType type, const std::string &name)
+{
+    std::unordered_map<std::string, int>::iterator it = names_[type].find(name);
+    return it != names_[type].end() ? it->second : -1;
+}
+
+
+ResourceManager::Asset &ResourceManager::Get(ResourceType type, const std::string &name)
+{
+    int asset = Find(type, name);
+    if (asset < 0) {
+        throw(std::runtime_error(std::string("Unknown ") + resource_type_names_g[type] + " " + name));
+    }
+    return assets_[asset];
+}
+
+
+ResourceManager::Asset &ResourceManager::Register(ResourceType type, const std::string &name, int index, size_t bytes)
+{
+    Asset asset;
+    asset.name = name;
+    asset.type = type;
+    asset.index = index;
+    asset.refs = 0;
+    asset.bytes = bytes;
+    names_[type][name] = (int) assets_.size();
+    assets_.push_back(asset);
+    return assets_.back();
+}
+
+
+int ResourceManager::AddTexture(const std::string &name, const std::string &file)
+{
+    // Registering a texture twice returns the same handle
+    int asset = Find(RESOURCE_TEXTURE, name);
+    if (asset >= 0) {
+        return assets_[asset].index;
+    }
+
+    // Baked textures are uploaded straight from the mapped pack
+    int handle;
+    const PackEntry *entry = pack_.IsOpen() ? pack_.Find(file) : NULL;
+    if (entry && entry->type == PACK_TEXTURE && entry->size == (uint64_t) entry->width * entry->height * 4) {
+        handle = atlas_.Add(file.c_str(), pack_.GetData(entry), (int) entry->width, (int) entry->height);
+    } else {
+        handle = atlas_.Add((directory_ + file).c_str());
+    }
+    texture_assets_.push_back((int) assets_.size());
+    Register(RESOURCE_TEXTURE, name, handle, 0);
+    return handle;
+}
+
+
+void ResourceManager::LoadTextures(void)
+{
+    // Without an OpenGL context only the handles are needed
+    if (headless_) {
+        return;
+    }
+
+    // Decode and upload all textures at once
+    auto start = std::chrono::steady_clock::now();
+    atlas_.Build(pool_);
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Record the memory of each texture (RGBA8) and report the load times
+    std::cout << "Loaded " << texture_assets_.size() << " textures in " << total_ms << " ms ("
+              << (pool_ ? pool_->GetNumThreads() : 0) << " decoding threads)" << std::endl;
+    for (int handle = 0; handle < texture_assets_.size(); handle++) {
+        Asset &asset = assets_[texture_assets_[handle]];
+        glm::ivec2 size = atlas_.GetRegionSize(handle);
+        asset.bytes = (size_t) size.x * size.y * 4;
+        std::cout << "  " << std::left << std::setw(28) << asset.name << std::right
+                  << " decode " << std::setw(8) << atlas_.GetDecodeTime(handle) << " ms"
+                  << "  upload " << std::setw(8) << atlas_.GetUploadTime(handle) << " ms" << std::endl;
+    }
+}
+
+
+const std::string &ResourceManager::LoadText(const std::string &name, const std::string &file)
+{
+    int asset = Find(RESOURCE_TEXT, name);
+    if (asset < 0) {
+        const PackEntry *entry = pack_.IsOpen() ? pack_.Find(file) : NULL;
+        if (entry && entry->type == PACK_TEXT) {
+            texts_.push_back(std::string((const char *) pack_.GetData(entry), (size_t) entry->size));
+        } else {
+            texts_.push_back(LoadTextFile((directory_ + file).c_str()));
+        }
+        Register(RESOURCE_TEXT, name, (int) texts_.size() - 1, texts_.back().size());
+        asset = (int) assets_.size() - 1;
+    }
+    assets_[asset].refs++;
+    return texts_[assets_[asset].index];
+}
+
+
+Shader *ResourceManager::LoadShader(const std::string &name, const std::string &vert_file, const std::string &frag_file)
+{
+    int asset = Find(RESOURCE_SHADER, name);
+    if (asset < 0) {
+        // The sources are text assets, so they are only read once
+        const std::string &vert_source = LoadText(vert_file, vert_file);
+        const std::string &frag_source = LoadText(frag_file, frag_file);
+
+        shaders_.emplace_back();
+        if (!headless_) {
+            Shader &shader = shaders_.back();
+            shader.InitFromSource(vert_source, frag_source, shader_cache_);
+            std::cout << "Shader " << name << (shader.IsFromCache() ? " loaded from cache in " : " compiled in ")
+                      << shader.GetLoadTime() << " ms" << std::endl;
+        }
+        Register(RESOURCE_SHADER, name, (int) shaders_.size() - 1, 0);
+        asset = (int) assets_.size() - 1;
+    }
+    assets_[asset].refs++;
+    return &shaders_[assets_[asset].index];
+}
+
+
+int ResourceManager::GetTexture(const std::string &name)
+{
+
+    return Get(RESOURCE_TEXTURE, name).index;
+}
+
+
+Shader *ResourceManager::GetShader(const std::string &name)
+{
+
+    return &shaders_[Get(RESOURCE_SHADER, name).index];
+}
+
+
+const std::string &ResourceManager::GetText(const std::string &name)
+{
+
+    return texts_[Get(RESOURCE_TEXT, name).index];
+}
+
+
+int ResourceManager::AcquireTexture(const std::string &name)
+{
+    Asset &asset = Get(RESOURCE_TEXTURE, name);
+    asset.refs++;
+    return asset.index;
+}
+
+
+int ResourceManager::AcquireTexture(int handle, int count)
+{
+
+    assets_[texture_assets_[handle]].refs += count;
+    return handle;
+}
+
+
+void ResourceManager::ReleaseTexture(int handle)
+{
+
+    assets_[texture_assets_[handle]].refs--;
+}
+
+
+void ResourceManager::ReleaseGraphics(void)
+{
+    for (int i = 0; i < shaders_.size(); i++) {
+        shaders_[i].Release();
+    }
+    atlas_.Release();
+}
+
+
+void ResourceManager::PrintStats(void)
+{
+    size_t total = 0;
+
+    std::cout << "Resources" << std::endl;
+    for (int i = 0; i < assets_.size(); i++) {
+        const Asset &asset = assets_[i];
+        std::cout << "  " << std::left << std::setw(8) << resource_type_names_g[asset.type]
+                  << std::setw(28) << asset.name
+                  << " refs " << std::right << std::setw(5) << asset.refs
+                  << "  " << std::setw(10) << asset.bytes << " bytes" << std::endl;
+        total += asset.bytes;
+    }
+
+    // The atlas also holds padding and free space around the textures
+    size_t atlas_bytes = (size_t) atlas_.GetWidth() * atlas_.GetHeight() * 4;
+    std::cout << "  total " << total << " bytes in assets, atlas texture " << atlas_bytes << " bytes" << std::endl;
+}
+
+} // namespace game
@@ -0,0 +1,140 @@
+#ifndef RESOURCE_MANAGER_H_
+#define RESOURCE_MANAGER_H_
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "asset_pack.h"
+#include "shader.h"
+#include "texture_atlas.h"
+#include "thread_pool.h"
+
+namespace game {
+
+    // Kinds of assets held by the resource manager
+    enum ResourceType {
+        RESOURCE_TEXTURE = 0,
+        RESOURCE_SHADER,
+        RESOURCE_TEXT,
+        NUM_RESOURCE_TYPES
+    };
+
+    /*
+        ResourceManager loads every texture, shader and text file once and
+        hands out handles to them by name
+        A texture handle is the index of the texture's region in the atlas,
+        so changing how an object looks is just a change of handle and never
+        touches the disk or the image decoder at run time
+    */
+    class ResourceManager {
+
+        public:
+            // Constructor and destructor
+            ResourceManager(void);
+            ~ResourceManager();
+
+            // Set the directory that asset files are relative to and the
+            // workers used to decode textures (can be NULL)
+            // Without an OpenGL context (headless) textures are only
+            // registered, so that their handles are still valid
+            void Init(const std::string &directory, bool headless, ThreadPool *pool);
+
+            // Map a pack made by the AssetBaker tool, returns false if it
+            // cannot be opened. Assets found in the pack are read from it
+            // (textures already decoded), anything else falls back to the
+            // loose files in the directory
+            bool OpenPack(const std::string &file);
+
+            // Directory where linked shader programs are cached between
+            // runs, empty to always compile shaders from source
+            inline void SetShaderCache(const std::string &directory) { shader_cache_ = directory; }
+
+            // Register a texture file under a name, returns its handle
+            // Nothing is loaded until LoadTextures() is called
+            int AddTexture(const std::string &name, const std::string &file);
+
+            // Load all registered textures into the atlas (called once)
+            // and report the time spent on each
+            void LoadTextures(void);
+
+            // Load a text file under a name, later calls return the cached contents
+            const std::string &LoadText(const std::string &name, const std::string &file);
+
+            // Load and link a shader under a name, later calls return the same shader
+            Shader *LoadShader(const std::string &name, const std::string &vert_file, const std::string &frag_file);
+
+            // Look up assets by name (throws if the name is unknown)
+            int GetTexture(const std::string &name);
+            Shader *GetShader(const std::string &name);
+            const std::string &GetText(const std::string &name);
+
+            // Count the game objects holding a texture handle
+            // Acquiring returns the handle, so it can be passed on directly
+            // A handle can be acquired for several objects at once
+            int AcquireTexture(const std::string &name);
+            int AcquireTexture(int handle, int count = 1);
+            void ReleaseTexture(int handle);
+
+            // Delete the OpenGL objects of the assets, while the context is
+            // still there (their destructors do it otherwise)
+            void ReleaseGraphics(void);
+
+            // Atlas holding all textures
+            inline TextureAtlas *GetAtlas(void) { return &atlas_; }
+
+            // Print every asset with its reference count and memory use
+            void PrintStats(void);
+
+        private:
+            // Bookkeeping for one asset
+            struct Asset {
+                std::string name;
+                ResourceType type;
+                int index;      // atlas region, shader or text index
+                int refs;       // number of users holding the asset
+                size_t bytes;   // memory used by the asset
+            };
+
+            // Directory that asset files are relative to
+            std::string directory_;
+
+            // Whether there is an OpenGL context to load into
+            bool headless_;
+
+            // Workers that decode textures
+            ThreadPool *pool_;
+
+            // Baked assets, used before the loose files when open
+            AssetPack pack_;
+
+            // Directory of the shader program binary cache
+            std::string shader_cache_;
+
+            // All assets, and their position in this list by type and name
+            std::vector<Asset> assets_;
+            std::unordered_map<std::string, int> names_[NUM_RESOURCE_TYPES];
+
+            // Position in the asset list of each texture handle
+            std::vector<int> texture_assets_;
+
+            // Loaded data (deques keep references valid as they grow)
+            TextureAtlas atlas_;
+            std::deque<Shader> shaders_;
+            std::deque<std::string> texts_;
+
+            // Find an asset by type and name, returns -1 if it is not loaded
+            int Find(ResourceType type, const std::string &name);
+
+            // Find an asset by type and name, throws if it is not loaded
+            Asset &Get(ResourceType type, const std::string &name);
+
+            // Add an asset to the lists
+            Asset &Register(ResourceType type, const std::string &name, int index, size_t bytes);
+
+    }; // class ResourceManager
+
+} // namespace game
+
+#endif // RESOURCE_MANAGER_H_
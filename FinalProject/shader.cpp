@@ -1,18 +1,63 @@
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <stdint.h>
+#include <stdio.h>
 #include <string>
+#include <vector>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "file_utils.h"
+#include "geometry.h"
+#include "gl_state.h"
 #include "shader.h"
 
 namespace game {
 
+// Names of the vertex attributes, in the order of the VertexAttribute enum
+const char *attribute_names_g[NUM_VERTEX_ATTRIBUTES] = {
+    "vertex",
+    "color",
+    "uv",
+    "instance_position",
+    "instance_scale",
+    "instance_region"
+};
+
+// Tag at the start of cached program binaries
+const uint32_t program_binary_magic_g = 0x42505347;  // "GSPB"
+
+
+// 64-bit FNV-1a hash of a string, continuing from a previous hash
+static uint64_t HashString(const std::string &str, uint64_t hash = 14695981039346656037ULL)
+{
+    for (int i = 0; i < str.size(); i++) {
+        hash ^= (unsigned char) str[i];
+        hash *= 1099511628211ULL;
+    }
+    // Separate consecutive strings
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+
+// A GL string, empty if the driver does not report it
+static std::string GetGLString(GLenum name)
+{
+    const GLubyte *str = glGetString(name);
+    return str ? std::string((const char *) str) : std::string();
+}
+
+
 Shader::Shader(void)
 {
     // Don't do work in the constructor, leave it for the Init() function
 
     // Only initialize variables with default values
     shader_program_ = 0;
+    load_ms_ = 0.0;
+    from_cache_ = false;
 }
 
 
@@ -20,12 +65,56 @@ void Shader::Init(const char *vertPath, const char *fragPath)
 {
    
     // Load shader program source code
+    InitFromSource(LoadTextFile(vertPath), LoadTextFile(fragPath));
+}
+
+
+void Shader::InitFromSource(const std::string &vert_source, const std::string &frag_source, const std::string &cache_directory)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Program binaries need OpenGL 4.1 or ARB_get_program_binary
+    bool use_cache = !cache_directory.empty() && (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary);
+
+    // The cached binary is only valid for the same sources, attribute
+    // bindings and driver
+    std::string cache_file;
+    if (use_cache) {
+        uint64_t hash = HashString(vert_source);
+        hash = HashString(frag_source, hash);
+        for (int i = 0; i < NUM_VERTEX_ATTRIBUTES; i++) {
+            hash = HashString(attribute_names_g[i], hash);
+        }
+        hash = HashString(GetGLString(GL_VENDOR), hash);
+        hash = HashString(GetGLString(GL_RENDERER), hash);
+        hash = HashString(GetGLString(GL_VERSION), hash);
+        char name[32];
+        snprintf(name, sizeof(name), "/shader_%016llx.bin", (unsigned long long) hash);
+        cache_file = cache_directory + name;
+    }
+
+    // Load the cached binary, or compile and store it
+    from_cache_ = use_cache && LoadBinary(cache_file);
+    if (!from_cache_) {
+        Compile(vert_source, frag_source, use_cache);
+        if (use_cache) {
+            SaveBinary(cache_file);
+        }
+    }
+
+    // Cache the locations of all uniforms and attributes
+    ReflectProgram();
+    load_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+void Shader::Compile(const std::string &vert_source, const std::string &frag_source, bool retrievable)
+{
+
     // Vertex program
-    std::string vp = LoadTextFile(vertPath);
-    const char *source_vp = vp.c_str();
+    const char *source_vp = vert_source.c_str();
     // Fragment program
-    std::string fp = LoadTextFile(fragPath);
-    const char *source_fp = fp.c_str();
+    const char *source_fp = frag_source.c_str();
 
     // Create a shader from vertex program source code
     GLuint vs = glCreateShader(GL_VERTEX_SHADER);
@@ -59,6 +148,18 @@ void Shader::Init(const char *vertPath, const char *fragPath)
     shader_program_ = glCreateProgram();
     glAttachShader(shader_program_, vs);
     glAttachShader(shader_program_, fs);
+
+    // Use the same attribute locations in every shader, so that vertex
+    // arrays work with all of them
+    for (int i = 0; i < NUM_VERTEX_ATTRIBUTES; i++) {
+        glBindAttribLocation(shader_program_, i, attribute_names_g[i]);
+    }
+
+    // Ask the driver to keep the binary around for the cache
+    if (retrievable) {
+        glProgramParameteri(shader_program_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(shader_program_);
 
     // Check if shaders were linked successfully
@@ -76,66 +177,264 @@ void Shader::Init(const char *vertPath, const char *fragPath)
 }
 
 
+bool Shader::LoadBinary(const std::string &fname)
+{
+    std::ifstream f(fname.c_str(), std::ios::binary);
+    if (!f) {
+        return false;
+    }
+
+    // Header with the binary format, then the binary itself
+    uint32_t magic;
+    GLenum format;
+    uint32_t length;
+    if (!f.read((char *) &magic, sizeof(magic)) || !f.read((char *) &format, sizeof(format)) ||
+        !f.read((char *) &length, sizeof(length)) || magic != program_binary_magic_g) {
+        return false;
+    }
+
+    // The binary fills the rest of the file, a length that does not match is
+    // a damaged cache and is not allocated
+    std::streampos start = f.tellg();
+    f.seekg(0, std::ios::end);
+    std::streamoff remaining = f.tellg() - start;
+    f.seekg(start);
+    if (length == 0 || remaining != (std::streamoff) length) {
+        return false;
+    }
+    std::vector<char> binary(length);
+    if (!f.read(binary.data(), length)) {
+        return false;
+    }
+
+    // The driver can still reject the binary, for example after an update
+    shader_program_ = glCreateProgram();
+    glProgramBinary(shader_program_, format, binary.data(), (GLsizei) length);
+    GLint status;
+    glGetProgramiv(shader_program_, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(shader_program_);
+        shader_program_ = 0;
+        return false;
+    }
+    return true;
+}
+
+
+void Shader::SaveBinary(const std::string &fname)
+{
+    GLint length = 0;
+    glGetProgramiv(shader_program_, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(shader_program_, length, &length, &format, binary.data());
+
+    // Failing to write the cache only costs a compile next time
+    std::ofstream f(fname.c_str(), std::ios::binary | std::ios::trunc);
+    uint32_t size = (uint32_t) length;
+    f.write((const char *) &program_binary_magic_g, sizeof(program_binary_magic_g));
+    f.write((const char *) &format, sizeof(format));
+    f.write((const char *) &size, sizeof(size));
+    f.write(binary.data(), length);
+}
+
+
+void Shader::ReflectProgram(void)
+{
+    GLint count;
+    GLint max_length;
+    GLint size;
+    GLenum type;
+
+    uniforms_.clear();
+    attributes_.clear();
+
+    // Active uniforms
+    // Arrays are reported as "name[0]", store them under their plain name
+    glGetProgramiv(shader_program_, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(shader_program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::string name(max_length + 1, '\0');
+    for (int i = 0; i < count; i++) {
+        GLsizei length;
+        glGetActiveUniform(shader_program_, i, (GLsizei) name.size(), &length, &size, &type, &name[0]);
+        std::string uniform_name = name.substr(0, length);
+        if (uniform_name.size() > 3 && uniform_name.compare(uniform_name.size() - 3, 3, "[0]") == 0) {
+            uniform_name.resize(uniform_name.size() - 3);
+        }
+        uniforms_[uniform_name] = glGetUniformLocation(shader_program_, uniform_name.c_str());
+    }
+
+    // Active attributes
+    glGetProgramiv(shader_program_, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(shader_program_, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+    name.assign(max_length + 1, '\0');
+    for (int i = 0; i < count; i++) {
+        GLsizei length;
+        glGetActiveAttrib(shader_program_, i, (GLsizei) name.size(), &length, &size, &type, &name[0]);
+        std::string attribute_name = name.substr(0, length);
+        attributes_[attribute_name] = glGetAttribLocation(shader_program_, attribute_name.c_str());
+    }
+}
+
+
+GLint Shader::GetUniformLocation(const std::string &name)
+{
+    // Uniforms that the compiler optimized away have no location
+    std::unordered_map<std::string, GLint>::iterator it = uniforms_.find(name);
+    return it != uniforms_.end() ? it->second : -1;
+}
+
+
+GLint Shader::GetAttribLocation(const std::string &name)
+{
+    // Attributes that the compiler optimized away have no location
+    std::unordered_map<std::string, GLint>::iterator it = attributes_.find(name);
+    return it != attributes_.end() ? it->second : -1;
+}
+
+
+void Shader::SetUniformBlock(const GLchar *name, GLuint binding)
+{
+    GLuint index = glGetUniformBlockIndex(shader_program_, name);
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(shader_program_, index, binding);
+    }
+}
+
+
 void Shader::SetUniform1i(const GLchar *name, int value)
 {
 
-    glUniform1i(glGetUniformLocation(shader_program_, name), value);
+    SetUniform1i(GetUniformLocation(name), value);
+}
+
+
+void Shader::SetUniform1i(GLint location, int value)
+{
+
+    glUniform1i(location, value);
 }
 
 
 void Shader::SetUniform1f(const GLchar *name, float value)
 {
 
-    glUniform1f(glGetUniformLocation(shader_program_, name), value);
+    SetUniform1f(GetUniformLocation(name), value);
+}
+
+
+void Shader::SetUniform1f(GLint location, float value)
+{
+
+    glUniform1f(location, value);
 }
 
 
 void Shader::SetUniform2f(const GLchar *name, const glm::vec2 &vector)
 {
 
-    glUniform2f(glGetUniformLocation(shader_program_, name), vector.x, vector.y);
+    SetUniform2f(GetUniformLocation(name), vector);
+}
+
+
+void Shader::SetUniform2f(GLint location, const glm::vec2 &vector)
+{
+
+    glUniform2f(location, vector.x, vector.y);
 }
 
 
 void Shader::SetUniform3f(const GLchar *name, const glm::vec3 &vector)
 {
 
-    glUniform3f(glGetUniformLocation(shader_program_, name), vector.x, vector.y, vector.z);
+    SetUniform3f(GetUniformLocation(name), vector);
+}
+
+
+void Shader::SetUniform3f(GLint location, const glm::vec3 &vector)
+{
+
+    glUniform3f(location, vector.x, vector.y, vector.z);
 }
 
 
 void Shader::SetUniform4f(const GLchar *name, const glm::vec4 &vector)
 {
 
-    glUniform4f(glGetUniformLocation(shader_program_, name), vector.x, vector.y, vector.z, vector.w);
+    SetUniform4f(GetUniformLocation(name), vector);
+}
+
+
+void Shader::SetUniform4f(GLint location, const glm::vec4 &vector)
+{
+
+    glUniform4f(location, vector.x, vector.y, vector.z, vector.w);
+}
+
+
+void Shader::SetUniform4fv(const GLchar *name, int count, const glm::vec4 *vectors)
+{
+
+    SetUniform4fv(GetUniformLocation(name), count, vectors);
+}
+
+
+void Shader::SetUniform4fv(GLint location, int count, const glm::vec4 *vectors)
+{
+
+    glUniform4fv(location, count, glm::value_ptr(vectors[0]));
 }
 
 
 void Shader::SetUniformMat4(const GLchar *name, const glm::mat4 &matrix)
 {
 
-    glUniformMatrix4fv(glGetUniformLocation(shader_program_, name), 1, GL_FALSE, glm::value_ptr(matrix));
+    SetUniformMat4(GetUniformLocation(name), matrix);
+}
+
+
+void Shader::SetUniformMat4(GLint location, const glm::mat4 &matrix)
+{
+
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
 
 Shader::~Shader() 
 {
 
+    Release();
+}
+
+
+void Shader::Release(void)
+{
+    // Nothing was created without an OpenGL context (headless)
+    if (!shader_program_) {
+        return;
+    }
+
+    // The program name can be reused, so the cached binding is no longer valid
     glDeleteProgram(shader_program_);
+    shader_program_ = 0;
+    GLState::Invalidate();
 }
 
 
 void Shader::Enable() 
 {
 
-    glUseProgram(shader_program_);
+    GLState::UseProgram(shader_program_);
 }
 
 
 void Shader::Disable()
 {
 
-    glUseProgram(0);
+    GLState::UseProgram(0);
 }
 
 } // namespace game
@@ -4,6 +4,8 @@
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
 
 namespace game {
 
@@ -15,37 +17,95 @@ namespace game {
             ~Shader();
 
             // Initialize shader with source files
+            // The locations of all active uniforms and attributes are
+            // looked up once, after linking
             void Init(const char *vertPath, const char *fragPath);
 
+            // Initialize shader with source code already in memory
+            // With a cache directory, the linked program binary is stored
+            // there under a hash of the sources and the driver, and later
+            // runs load it instead of compiling (falling back to compiling
+            // if the driver rejects it)
+            void InitFromSource(const std::string &vert_source, const std::string &frag_source, const std::string &cache_directory = "");
+
+            // Delete the program, while the OpenGL context is still there
+            // (the destructor does it otherwise)
+            void Release(void);
+
             // Enable or disable this specific shader
             void Enable();
             void Disable();
 
+            // Location of an active uniform or attribute, or -1 if the
+            // shader does not use it. Keep the result and use it with the
+            // setters below to avoid looking up names every frame
+            GLint GetUniformLocation(const std::string &name);
+            GLint GetAttribLocation(const std::string &name);
+
+            // Connect a uniform block of the shader to a uniform buffer binding point
+            void SetUniformBlock(const GLchar *name, GLuint binding);
+
             // Sets a uniform integer variable in your shader program to a value
             void SetUniform1i(const GLchar *name, int value);
+            void SetUniform1i(GLint location, int value);
 
             // Sets a uniform float variable in your shader program to a value
             void SetUniform1f(const GLchar *name, float value);
+            void SetUniform1f(GLint location, float value);
 
             // Sets a uniform vector2 variable in your shader program to a vector
             void SetUniform2f(const GLchar *name, const glm::vec2 &vector);
+            void SetUniform2f(GLint location, const glm::vec2 &vector);
 
             // Sets a uniform vector3 variable in your shader program to a vector
             void SetUniform3f(const GLchar *name, const glm::vec3 &vector);
+            void SetUniform3f(GLint location, const glm::vec3 &vector);
 
             // Sets a uniform vector4 variable in your shader program to a vector
             void SetUniform4f(const GLchar *name, const glm::vec4 &vector);
+            void SetUniform4f(GLint location, const glm::vec4 &vector);
+
+            // Sets a uniform vector4 array in your shader program to an array of vectors
+            void SetUniform4fv(const GLchar *name, int count, const glm::vec4 *vectors);
+            void SetUniform4fv(GLint location, int count, const glm::vec4 *vectors);
 
             // Sets a uniform matrix4x4 variable in your shader program to a matrix4x4
             void SetUniformMat4(const GLchar *name, const glm::mat4 &matrix);
+            void SetUniformMat4(GLint location, const glm::mat4 &matrix);
 
             // Get OpenGL reference of shader program
             inline GLuint GetShaderProgram(void) { return shader_program_; }
 
+            // Time spent creating the program in milliseconds, and whether
+            // it was loaded from the binary cache rather than compiled
+            inline double GetLoadTime(void) { return load_ms_; }
+            inline bool IsFromCache(void) { return from_cache_; }
+
         private:
             // Reference to shader program
             GLuint shader_program_;
 
+            // How the program was created
+            double load_ms_;
+            bool from_cache_;
+
+            // Locations of the active uniforms and attributes, by name
+            std::unordered_map<std::string, GLint> uniforms_;
+            std::unordered_map<std::string, GLint> attributes_;
+
+            // Compile and link the program from source
+            void Compile(const std::string &vert_source, const std::string &frag_source, bool retrievable);
+
+            // Load the program from a cached binary, returns false on a miss
+            // or if the driver rejects the binary
+            bool LoadBinary(const std::string &fname);
+
+            // Store the binary of the linked program
+            void SaveBinary(const std::string &fname);
+
+            // Look up the active uniforms and attributes of the linked program
+            void ReflectProgram(void);
+
     }; // class Shader
 } // namespace game
 
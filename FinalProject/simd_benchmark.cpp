@@ -0,0 +1,185 @@
+// Microbenchmark of the simulation kernels
+//
+//   SimdBenchmark [entities] [frames]
+//
+// Runs the enemy update (patrol, chase, integration and the distance test
+// against the player) over the same entities with the old per-object path
+// (heap-allocated objects with a virtual Update and a double precision
+// rotation per object) and with the batch kernels of every instruction set
+// the CPU supports, then reports the time per frame and the speedup
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include <random>
+#include <stdlib.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "simd_kernels.h"
+
+// Defaults
+const int benchmark_entities_g = 100000;
+const int benchmark_frames_g = 200;
+const double benchmark_delta_time_g = 1.0 / 60.0;
+
+// Player position and chase range used by both paths
+const glm::vec3 benchmark_player_g(0.5f, 0.25f, 0.0f);
+const float benchmark_chase_range_g = 1.5f;
+
+
+// An enemy as it was stored before the entity arrays: one object per
+// enemy, updated through a virtual call
+class LegacyObject {
+
+    public:
+        LegacyObject(const glm::vec3 &position) {
+            position_ = position;
+            velocity_ = glm::vec3(0.0f, 0.0f, 0.0f);
+            roPoint = position - glm::vec3(0.2f, 0.2f, 0.0f);
+            state = false;
+        }
+        virtual ~LegacyObject() {}
+
+        virtual void Update(double delta_time) {
+            position_ += velocity_ * ((float) delta_time);
+        }
+
+        glm::vec3 position_;
+        glm::vec3 velocity_;
+        glm::vec3 roPoint;
+        glm::vec3 player;
+        bool state;
+};
+
+
+// One frame of the old enemy loop
+static void UpdateLegacy(std::vector<LegacyObject *> &objects, double delta_time)
+{
+    for (int k = 0; k < objects.size(); k++) {
+        LegacyObject *obj = objects[k];
+        obj->player = benchmark_player_g;
+        if (obj->state == false) {
+            double xRot = (obj->roPoint[0] + (obj->position_[0] - obj->roPoint[0]) * cos(0.5 * delta_time) - (obj->position_[1] - obj->roPoint[1]) * sin(0.5 * delta_time));
+            double yRot = (obj->roPoint[1] + (obj->position_[1] - obj->roPoint[1]) * cos(0.5 * delta_time) + (obj->position_[0] - obj->roPoint[0]) * sin(0.5 * delta_time));
+            obj->position_ = glm::vec3(xRot, yRot, 0.0);
+        } else {
+            obj->velocity_ = 0.1f * (obj->player - obj->position_);
+        }
+        obj->Update(delta_time);
+
+        if (glm::length(obj->position_ - obj->player) < benchmark_chase_range_g) {
+            obj->state = true;
+        }
+    }
+}
+
+
+// Enemies as packed component arrays
+struct PackedEnemies {
+    std::vector<float> pos_x, pos_y, vel_x, vel_y, pivot_x, pivot_y, distance_sq;
+    std::vector<unsigned char> chasing;
+};
+
+
+// One frame of the enemy update with the batch kernels
+static void UpdatePacked(const game::SimdKernels &kernels, PackedEnemies &e, double delta_time)
+{
+    int n = (int) e.pos_x.size();
+    kernels.patrol(e.pos_x.data(), e.pos_y.data(), e.pivot_x.data(), e.pivot_y.data(), e.chasing.data(), n, (float) cos(0.5 * delta_time), (float) sin(0.5 * delta_time));
+    kernels.chase(e.pos_x.data(), e.pos_y.data(), e.vel_x.data(), e.vel_y.data(), e.chasing.data(), n, benchmark_player_g.x, benchmark_player_g.y, 0.1f);
+    kernels.integrate(e.pos_x.data(), e.pos_y.data(), e.vel_x.data(), e.vel_y.data(), n, (float) delta_time);
+    kernels.distance_sq(e.pos_x.data(), e.pos_y.data(), n, benchmark_player_g.x, benchmark_player_g.y, e.distance_sq.data());
+
+    float range_sq = benchmark_chase_range_g * benchmark_chase_range_g;
+    for (int i = 0; i < n; i++) {
+        e.chasing[i] |= e.distance_sq[i] < range_sq;
+    }
+}
+
+
+// Milliseconds per frame of a frame function
+template <typename F>
+static double TimeFrames(int frames, F frame)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        frame();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+
+int main(int argc, char **argv)
+{
+    int entities = argc > 1 ? atoi(argv[1]) : benchmark_entities_g;
+    int frames = argc > 2 ? atoi(argv[2]) : benchmark_frames_g;
+
+    // Same random enemies for every path, a few of them already chasing
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> coord(-50.0f, 50.0f);
+    std::vector<glm::vec3> positions(entities);
+    std::vector<unsigned char> chasing(entities);
+    for (int i = 0; i < entities; i++) {
+        positions[i] = glm::vec3(coord(rng), coord(rng), 0.0f);
+        chasing[i] = (rng() % 8) == 0;
+    }
+
+    // Old path
+    std::vector<LegacyObject *> objects;
+    for (int i = 0; i < entities; i++) {
+        objects.push_back(new LegacyObject(positions[i]));
+        objects.back()->state = chasing[i] != 0;
+    }
+    double legacy_ms = TimeFrames(frames, [&objects]() { UpdateLegacy(objects, benchmark_delta_time_g); });
+
+    std::cout << "Simulation kernels: " << entities << " enemies, " << frames << " frames" << std::endl;
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "  " << std::left << std::setw(12) << "per-object" << std::right
+              << std::setw(10) << legacy_ms << " ms/frame" << std::setw(10) << legacy_ms * 1e6 / entities << " ns/enemy" << std::endl;
+
+    // Batch kernels of every supported instruction set
+    std::vector<float> reference_x;
+    for (int level = 0; level < game::NUM_SIMD_LEVELS; level++) {
+        const game::SimdKernels *kernels = game::GetSimdKernels((game::SimdLevel) level);
+        if (!kernels) {
+            std::cout << "  " << std::left << std::setw(12) << game::GetSimdLevelName((game::SimdLevel) level) << "not supported" << std::endl;
+            continue;
+        }
+
+        PackedEnemies e;
+        for (int i = 0; i < entities; i++) {
+            e.pos_x.push_back(positions[i].x);
+            e.pos_y.push_back(positions[i].y);
+            e.vel_x.push_back(0.0f);
+            e.vel_y.push_back(0.0f);
+            e.pivot_x.push_back(positions[i].x - 0.2f);
+            e.pivot_y.push_back(positions[i].y - 0.2f);
+        }
+        e.chasing = chasing;
+        e.distance_sq.resize(entities);
+        double ms = TimeFrames(frames, [kernels, &e]() { UpdatePacked(*kernels, e, benchmark_delta_time_g); });
+
+        // Every instruction set must give exactly the scalar results
+        bool identical = true;
+        if (reference_x.empty()) {
+            reference_x = e.pos_x;
+        } else {
+            identical = reference_x == e.pos_x;
+        }
+
+        std::cout << "  " << std::left << std::setw(12) << game::GetSimdLevelName((game::SimdLevel) level) << std::right
+                  << std::setw(10) << ms << " ms/frame" << std::setw(10) << ms * 1e6 / entities << " ns/enemy"
+                  << std::setw(8) << legacy_ms / ms << "x" << (identical ? "" : "  RESULTS DIFFER FROM SCALAR") << std::endl;
+    }
+
+    // How far the single precision rotation drifts from the old double
+    // precision one over the run
+    float max_drift = 0.0f;
+    for (int i = 0; i < entities; i++) {
+        max_drift = fmaxf(max_drift, fabsf(objects[i]->position_.x - reference_x[i]));
+        delete objects[i];
+    }
+    std::cout << "  largest difference to the per-object path: " << std::scientific << max_drift << std::endl;
+    return 0;
+}
@@ -0,0 +1,264 @@
+#include <string.h>
+
+#include "simd_kernels.h"
+
+// SSE2 is part of every x86-64 CPU
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace game {
+
+// Names of the instruction sets, in the order of the SimdLevel enum
+const char *simd_level_names_g[NUM_SIMD_LEVELS] = {
+    "scalar",
+    "sse2",
+    "avx2"
+};
+
+
+void IntegrateScalar(float *pos_x, float *pos_y, const float *vel_x, const float *vel_y, int n, float dt)
+{
+    for (int i = 0; i < n; i++) {
+        pos_x[i] = pos_x[i] + vel_x[i] * dt;
+        pos_y[i] = pos_y[i] + vel_y[i] * dt;
+    }
+}
+
+
+void PatrolScalar(float *pos_x, float *pos_y, const float *pivot_x, const float *pivot_y, const unsigned char *chasing, int n, float cos_rot, float sin_rot)
+{
+    for (int i = 0; i < n; i++) {
+        if (!chasing[i]) {
+            float dx = pos_x[i] - pivot_x[i];
+            float dy = pos_y[i] - pivot_y[i];
+            pos_x[i] = (pivot_x[i] + dx * cos_rot) - dy * sin_rot;
+            pos_y[i] = (pivot_y[i] + dy * cos_rot) + dx * sin_rot;
+        }
+    }
+}
+
+
+void ChaseScalar(const float *pos_x, const float *pos_y, float *vel_x, float *vel_y, const unsigned char *chasing, int n, float target_x, float target_y, float gain)
+{
+    for (int i = 0; i < n; i++) {
+        if (chasing[i]) {
+            vel_x[i] = gain * (target_x - pos_x[i]);
+            vel_y[i] = gain * (target_y - pos_y[i]);
+        }
+    }
+}
+
+
+void DistanceSqScalar(const float *pos_x, const float *pos_y, int n, float x, float y, float *out)
+{
+    for (int i = 0; i < n; i++) {
+        float dx = pos_x[i] - x;
+        float dy = pos_y[i] - y;
+        out[i] = dx * dx + dy * dy;
+    }
+}
+
+
+#ifdef SIMD_HAS_SSE2
+
+// Mask of four lanes from four mask bytes (all ones where the byte is set)
+static inline __m128 LoadMaskSSE2(const unsigned char *mask)
+{
+    int bytes;
+    memcpy(&bytes, mask, sizeof(bytes));
+    __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_cvtsi32_si128(bytes);
+    v = _mm_unpacklo_epi8(v, zero);
+    v = _mm_unpacklo_epi16(v, zero);
+    return _mm_castsi128_ps(_mm_cmpgt_epi32(v, zero));
+}
+
+
+// Pick b where the mask is set and a elsewhere
+static inline __m128 SelectSSE2(__m128 mask, __m128 a, __m128 b)
+{
+
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+
+static void IntegrateSSE2(float *pos_x, float *pos_y, const float *vel_x, const float *vel_y, int n, float dt)
+{
+    __m128 t = _mm_set1_ps(dt);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(pos_x + i, _mm_add_ps(_mm_loadu_ps(pos_x + i), _mm_mul_ps(_mm_loadu_ps(vel_x + i), t)));
+        _mm_storeu_ps(pos_y + i, _mm_add_ps(_mm_loadu_ps(pos_y + i), _mm_mul_ps(_mm_loadu_ps(vel_y + i), t)));
+    }
+    IntegrateScalar(pos_x + i, pos_y + i, vel_x + i, vel_y + i, n - i, dt);
+}
+
+
+static void PatrolSSE2(float *pos_x, float *pos_y, const float *pivot_x, const float *pivot_y, const unsigned char *chasing, int n, float cos_rot, float sin_rot)
+{
+    __m128 c = _mm_set1_ps(cos_rot);
+    __m128 s = _mm_set1_ps(sin_rot);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_loadu_ps(pos_x + i);
+        __m128 py = _mm_loadu_ps(pos_y + i);
+        __m128 cx = _mm_loadu_ps(pivot_x + i);
+        __m128 cy = _mm_loadu_ps(pivot_y + i);
+        __m128 dx = _mm_sub_ps(px, cx);
+        __m128 dy = _mm_sub_ps(py, cy);
+        __m128 rx = _mm_sub_ps(_mm_add_ps(cx, _mm_mul_ps(dx, c)), _mm_mul_ps(dy, s));
+        __m128 ry = _mm_add_ps(_mm_add_ps(cy, _mm_mul_ps(dy, c)), _mm_mul_ps(dx, s));
+
+        // Chasing entities keep their position
+        __m128 mask = LoadMaskSSE2(chasing + i);
+        _mm_storeu_ps(pos_x + i, SelectSSE2(mask, rx, px));
+        _mm_storeu_ps(pos_y + i, SelectSSE2(mask, ry, py));
+    }
+    PatrolScalar(pos_x + i, pos_y + i, pivot_x + i, pivot_y + i, chasing + i, n - i, cos_rot, sin_rot);
+}
+
+
+static void ChaseSSE2(const float *pos_x, const float *pos_y, float *vel_x, float *vel_y, const unsigned char *chasing, int n, float target_x, float target_y, float gain)
+{
+    __m128 g = _mm_set1_ps(gain);
+    __m128 tx = _mm_set1_ps(target_x);
+    __m128 ty = _mm_set1_ps(target_y);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 vx = _mm_mul_ps(g, _mm_sub_ps(tx, _mm_loadu_ps(pos_x + i)));
+        __m128 vy = _mm_mul_ps(g, _mm_sub_ps(ty, _mm_loadu_ps(pos_y + i)));
+
+        // Patrolling entities keep their velocity
+        __m128 mask = LoadMaskSSE2(chasing + i);
+        _mm_storeu_ps(vel_x + i, SelectSSE2(mask, _mm_loadu_ps(vel_x + i), vx));
+        _mm_storeu_ps(vel_y + i, SelectSSE2(mask, _mm_loadu_ps(vel_y + i), vy));
+    }
+    ChaseScalar(pos_x + i, pos_y + i, vel_x + i, vel_y + i, chasing + i, n - i, target_x, target_y, gain);
+}
+
+
+static void DistanceSqSSE2(const float *pos_x, const float *pos_y, int n, float x, float y, float *out)
+{
+    __m128 px = _mm_set1_ps(x);
+    __m128 py = _mm_set1_ps(y);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(pos_x + i), px);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(pos_y + i), py);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+    }
+    DistanceSqScalar(pos_x + i, pos_y + i, n - i, x, y, out + i);
+}
+
+#endif // SIMD_HAS_SSE2
+
+
+// Whether the CPU and the operating system support AVX2
+static bool DetectAvx2(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // AVX registers must be enabled by the operating system (OSXSAVE, XCR0)
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+
+// Detection result, the CPU is only queried once
+static bool CpuHasAvx2(void)
+{
+    static bool has_avx2 = DetectAvx2();
+    return has_avx2;
+}
+
+
+// Kernels of each instruction set, NULL where unsupported
+static const SimdKernels scalar_kernels_g = { IntegrateScalar, PatrolScalar, ChaseScalar, DistanceSqScalar };
+#ifdef SIMD_HAS_SSE2
+static const SimdKernels sse2_kernels_g = { IntegrateSSE2, PatrolSSE2, ChaseSSE2, DistanceSqSSE2 };
+#endif
+
+
+const SimdKernels *GetSimdKernels(SimdLevel level)
+{
+    switch (level) {
+        case SIMD_SCALAR:
+            return &scalar_kernels_g;
+#ifdef SIMD_HAS_SSE2
+        case SIMD_SSE2:
+            return &sse2_kernels_g;
+#endif
+        case SIMD_AVX2:
+            return CpuHasAvx2() ? GetAvx2Kernels() : NULL;
+        default:
+            return NULL;
+    }
+}
+
+
+// Instruction set in use and its kernels, chosen on first use
+static SimdLevel simd_level_g = SIMD_SCALAR;
+static const SimdKernels *simd_kernels_g = NULL;
+
+
+const SimdKernels &GetSimdKernels(void)
+{
+    // Pick the fastest instruction set the CPU supports
+    if (!simd_kernels_g) {
+        for (int level = NUM_SIMD_LEVELS - 1; level >= SIMD_SCALAR; level--) {
+            if (SetSimdLevel((SimdLevel) level)) {
+                break;
+            }
+        }
+    }
+    return *simd_kernels_g;
+}
+
+
+bool SetSimdLevel(SimdLevel level)
+{
+    const SimdKernels *kernels = GetSimdKernels(level);
+    if (!kernels) {
+        return false;
+    }
+    simd_level_g = level;
+    simd_kernels_g = kernels;
+    return true;
+}
+
+
+SimdLevel GetSimdLevel(void)
+{
+    GetSimdKernels();
+    return simd_level_g;
+}
+
+
+const char *GetSimdLevelName(SimdLevel level)
+{
+
+    return simd_level_names_g[level];
+}
+
+} // namespace game
@@ -0,0 +1,63 @@
+#ifndef SIMD_KERNELS_H_
+#define SIMD_KERNELS_H_
+
+namespace game {
+
+    // Instruction sets the kernels can run on, from slowest to fastest
+    enum SimdLevel {
+        SIMD_SCALAR = 0,
+        SIMD_SSE2,
+        SIMD_AVX2,
+        NUM_SIMD_LEVELS
+    };
+
+    /*
+        Batch kernels over packed float arrays (one array per component)
+        Every version does the same float operations in the same order, so
+        all of them give bit-identical results and the simulation stays
+        deterministic whichever one the CPU runs. Masks are bytes, non-zero
+        for the entities the operation applies to
+    */
+    struct SimdKernels {
+        // pos += vel * dt
+        void (*integrate)(float *pos_x, float *pos_y, const float *vel_x, const float *vel_y, int n, float dt);
+
+        // Rotate the positions that are not masked around their pivot
+        void (*patrol)(float *pos_x, float *pos_y, const float *pivot_x, const float *pivot_y, const unsigned char *chasing, int n, float cos_rot, float sin_rot);
+
+        // vel = gain * (target - pos) for the masked entities
+        void (*chase)(const float *pos_x, const float *pos_y, float *vel_x, float *vel_y, const unsigned char *chasing, int n, float target_x, float target_y, float gain);
+
+        // Squared distance from each position to a point
+        void (*distance_sq)(const float *pos_x, const float *pos_y, int n, float x, float y, float *out);
+    };
+
+    // Kernels of the fastest instruction set the CPU supports (or the one
+    // chosen with SetSimdLevel), detected on first use
+    const SimdKernels &GetSimdKernels(void);
+
+    // Kernels of one instruction set, or NULL if the CPU (or the build)
+    // does not support it
+    const SimdKernels *GetSimdKernels(SimdLevel level);
+
+    // Choose the instruction set used by GetSimdKernels(), returns false if
+    // it is not supported
+    bool SetSimdLevel(SimdLevel level);
+
+    // Instruction set in use and its name
+    SimdLevel GetSimdLevel(void);
+    const char *GetSimdLevelName(SimdLevel level);
+
+    // Scalar kernels, also used for the elements left over by the vector loops
+    void IntegrateScalar(float *pos_x, float *pos_y, const float *vel_x, const float *vel_y, int n, float dt);
+    void PatrolScalar(float *pos_x, float *pos_y, const float *pivot_x, const float *pivot_y, const unsigned char *chasing, int n, float cos_rot, float sin_rot);
+    void ChaseScalar(const float *pos_x, const float *pos_y, float *vel_x, float *vel_y, const unsigned char *chasing, int n, float target_x, float target_y, float gain);
+    void DistanceSqScalar(const float *pos_x, const float *pos_y, int n, float x, float y, float *out);
+
+    // AVX2 kernels, built in their own file with AVX2 code generation
+    // Returns NULL if the build has no AVX2 support
+    const SimdKernels *GetAvx2Kernels(void);
+
+} // namespace game
+
+#endif // SIMD_KERNELS_H_
@@ -0,0 +1,113 @@
+// AVX2 versions of the batch kernels
+// This file is compiled with AVX2 code generation, so it must only be
+// called after checking that the CPU supports it (see simd_kernels.cpp).
+// It includes nothing but the intrinsics, so that no inline library code
+// built for AVX2 can end up shared with the rest of the program
+#include "simd_kernels.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace game {
+
+// Mask of eight lanes from eight mask bytes (all ones where the byte is set)
+static inline __m256 LoadMaskAVX2(const unsigned char *mask)
+{
+    __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) mask));
+    return _mm256_castsi256_ps(_mm256_cmpgt_epi32(v, _mm256_setzero_si256()));
+}
+
+
+static void IntegrateAVX2(float *pos_x, float *pos_y, const float *vel_x, const float *vel_y, int n, float dt)
+{
+    __m256 t = _mm256_set1_ps(dt);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(pos_x + i, _mm256_add_ps(_mm256_loadu_ps(pos_x + i), _mm256_mul_ps(_mm256_loadu_ps(vel_x + i), t)));
+        _mm256_storeu_ps(pos_y + i, _mm256_add_ps(_mm256_loadu_ps(pos_y + i), _mm256_mul_ps(_mm256_loadu_ps(vel_y + i), t)));
+    }
+    IntegrateScalar(pos_x + i, pos_y + i, vel_x + i, vel_y + i, n - i, dt);
+}
+
+
+static void PatrolAVX2(float *pos_x, float *pos_y, const float *pivot_x, const float *pivot_y, const unsigned char *chasing, int n, float cos_rot, float sin_rot)
+{
+    __m256 c = _mm256_set1_ps(cos_rot);
+    __m256 s = _mm256_set1_ps(sin_rot);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 px = _mm256_loadu_ps(pos_x + i);
+        __m256 py = _mm256_loadu_ps(pos_y + i);
+        __m256 cx = _mm256_loadu_ps(pivot_x + i);
+        __m256 cy = _mm256_loadu_ps(pivot_y + i);
+        __m256 dx = _mm256_sub_ps(px, cx);
+        __m256 dy = _mm256_sub_ps(py, cy);
+        __m256 rx = _mm256_sub_ps(_mm256_add_ps(cx, _mm256_mul_ps(dx, c)), _mm256_mul_ps(dy, s));
+        __m256 ry = _mm256_add_ps(_mm256_add_ps(cy, _mm256_mul_ps(dy, c)), _mm256_mul_ps(dx, s));
+
+        // Chasing entities keep their position
+        __m256 mask = LoadMaskAVX2(chasing + i);
+        _mm256_storeu_ps(pos_x + i, _mm256_blendv_ps(rx, px, mask));
+        _mm256_storeu_ps(pos_y + i, _mm256_blendv_ps(ry, py, mask));
+    }
+    PatrolScalar(pos_x + i, pos_y + i, pivot_x + i, pivot_y + i, chasing + i, n - i, cos_rot, sin_rot);
+}
+
+
+static void ChaseAVX2(const float *pos_x, const float *pos_y, float *vel_x, float *vel_y, const unsigned char *chasing, int n, float target_x, float target_y, float gain)
+{
+    __m256 g = _mm256_set1_ps(gain);
+    __m256 tx = _mm256_set1_ps(target_x);
+    __m256 ty = _mm256_set1_ps(target_y);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 vx = _mm256_mul_ps(g, _mm256_sub_ps(tx, _mm256_loadu_ps(pos_x + i)));
+        __m256 vy = _mm256_mul_ps(g, _mm256_sub_ps(ty, _mm256_loadu_ps(pos_y + i)));
+
+        // Patrolling entities keep their velocity
+        __m256 mask = LoadMaskAVX2(chasing + i);
+        _mm256_storeu_ps(vel_x + i, _mm256_blendv_ps(_mm256_loadu_ps(vel_x + i), vx, mask));
+        _mm256_storeu_ps(vel_y + i, _mm256_blendv_ps(_mm256_loadu_ps(vel_y + i), vy, mask));
+    }
+    ChaseScalar(pos_x + i, pos_y + i, vel_x + i, vel_y + i, chasing + i, n - i, target_x, target_y, gain);
+}
+
+
+static void DistanceSqAVX2(const float *pos_x, const float *pos_y, int n, float x, float y, float *out)
+{
+    __m256 px = _mm256_set1_ps(x);
+    __m256 py = _mm256_set1_ps(y);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(pos_x + i), px);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(pos_y + i), py);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+    }
+    DistanceSqScalar(pos_x + i, pos_y + i, n - i, x, y, out + i);
+}
+
+
+static const SimdKernels avx2_kernels_g = { IntegrateAVX2, PatrolAVX2, ChaseAVX2, DistanceSqAVX2 };
+
+
+const SimdKernels *GetAvx2Kernels(void)
+{
+
+    return &avx2_kernels_g;
+}
+
+} // namespace game
+
+#else
+
+namespace game {
+
+const SimdKernels *GetAvx2Kernels(void)
+{
+
+    return NULL;
+}
+
+} // namespace game
+
+#endif // __AVX2__
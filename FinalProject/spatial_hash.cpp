@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <math.h>
+
+#include "spatial_hash.h"
+
+namespace game {
+
+// Objects per chunk when inserting arrays on the job system
+const int spatial_hash_grain_g = 4096;
+
+SpatialHash::SpatialHash(void)
+{
+    // Initialize variables with default values
+    Init(2.0f, 1024);
+}
+
+
+void SpatialHash::Init(float cell_size, int num_buckets)
+{
+    cell_size_ = cell_size;
+
+    // Round the bucket count up to a power of two so that it can be masked
+    num_buckets_ = 1;
+    while (num_buckets_ < num_buckets) {
+        num_buckets_ *= 2;
+    }
+    bucket_mask_ = num_buckets_ - 1;
+
+    Clear();
+}
+
+
+void SpatialHash::Clear(void)
+{
+    // Keep the allocated memory, so that rebuilding every frame does not allocate
+    for (int i = 0; i < NUM_COLLISION_LAYERS; i++) {
+        entries_[i].clear();
+        built_[i] = false;
+        max_radius_[i] = 0.0f;
+    }
+}
+
+
+void SpatialHash::Insert(int id, CollisionLayer layer, const glm::vec3 &position, float radius)
+{
+    Entry entry;
+    entry.id = id;
+    entry.cell_x = CellCoord(position.x);
+    entry.cell_y = CellCoord(position.y);
+    entry.x = position.x;
+    entry.y = position.y;
+    entry.radius = radius;
+    entries_[layer].push_back(entry);
+
+    max_radius_[layer] = std::max(max_radius_[layer], radius);
+    built_[layer] = false;
+}
+
+
+void SpatialHash::InsertArrays(CollisionLayer layer, const float *pos_x, const float *pos_y, const float *scale, float radius_scale, int count, JobSystem *jobs)
+{
+    std::vector<Entry> &entries = entries_[layer];
+    int first = (int) entries.size();
+    entries.resize(first + count);
+
+    // Every chunk fills its own entries
+    Entry *out = entries.data() + first;
+    jobs->ParallelFor(0, count, spatial_hash_grain_g, [this, out, pos_x, pos_y, scale, radius_scale](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            Entry &entry = out[i];
+            entry.id = i;
+            entry.cell_x = CellCoord(pos_x[i]);
+            entry.cell_y = CellCoord(pos_y[i]);
+            entry.x = pos_x[i];
+            entry.y = pos_y[i];
+            entry.radius = radius_scale * scale[i];
+        }
+    });
+
+    // Largest radius of the layer
+    for (int i = 0; i < count; i++) {
+        max_radius_[layer] = std::max(max_radius_[layer], radius_scale * scale[i]);
+    }
+    built_[layer] = false;
+}
+
+
+void SpatialHash::BuildLayer(CollisionLayer layer)
+{
+    std::vector<Entry> &entries = entries_[layer];
+    std::vector<Entry> &sorted = sorted_[layer];
+    std::vector<int> &start = bucket_start_[layer];
+
+    // Keep about one object per bucket as the world fills up
+    if (entries.size() > num_buckets_) {
+        while (num_buckets_ < entries.size()) {
+            num_buckets_ *= 2;
+        }
+        bucket_mask_ = num_buckets_ - 1;
+        for (int i = 0; i < NUM_COLLISION_LAYERS; i++) {
+            built_[i] = false;
+        }
+    }
+
+    // Count the objects in each bucket
+    start.assign(num_buckets_ + 1, 0);
+    for (int i = 0; i < entries.size(); i++) {
+        start[Bucket(entries[i].cell_x, entries[i].cell_y) + 1]++;
+    }
+
+    // Turn the counts into the start of each bucket
+    for (int b = 0; b < num_buckets_; b++) {
+        start[b + 1] += start[b];
+    }
+
+    // Scatter the objects into their buckets, keeping insertion order
+    // within a bucket
+    sorted.resize(entries.size());
+    std::vector<int> &next = scratch_;
+    next.assign(start.begin(), start.end() - 1);
+    for (int i = 0; i < entries.size(); i++) {
+        sorted[next[Bucket(entries[i].cell_x, entries[i].cell_y)]++] = entries[i];
+    }
+
+    built_[layer] = true;
+}
+
+
+void SpatialHash::FindPairs(CollisionLayer a, CollisionLayer b, std::vector<CollisionPair> &pairs)
+{
+    pairs.clear();
+    if (entries_[a].empty() || entries_[b].empty()) {
+        return;
+    }
+
+    // Index the other layer by bucket
+    if (!built_[b]) {
+        BuildLayer(b);
+    }
+    const std::vector<Entry> &sorted = sorted_[b];
+    const std::vector<int> &start = bucket_start_[b];
+
+    for (int i = 0; i < entries_[a].size(); i++) {
+        const Entry &ea = entries_[a][i];
+
+        // Objects of layer b are stored by their center only, so look at
+        // every cell that a circle of the largest radius could reach
+        float reach = ea.radius + max_radius_[b];
+        int min_x = CellCoord(ea.x - reach);
+        int max_x = CellCoord(ea.x + reach);
+        int min_y = CellCoord(ea.y - reach);
+        int max_y = CellCoord(ea.y + reach);
+
+        for (int cy = min_y; cy <= max_y; cy++) {
+            for (int cx = min_x; cx <= max_x; cx++) {
+                int bucket = Bucket(cx, cy);
+                for (int j = start[bucket]; j < start[bucket + 1]; j++) {
+                    const Entry &eb = sorted[j];
+
+                    // Different cells can share a bucket
+                    if (eb.cell_x != cx || eb.cell_y != cy) {
+                        continue;
+                    }
+
+                    // Check if the bounding circles overlap
+                    float dx = ea.x - eb.x;
+                    float dy = ea.y - eb.y;
+                    float r = ea.radius + eb.radius;
+                    if (dx * dx + dy * dy < r * r) {
+                        CollisionPair pair;
+                        pair.first = ea.id;
+                        pair.second = eb.id;
+                        pairs.push_back(pair);
+                    }
+                }
+            }
+        }
+    }
+
+    // Report the pairs in a deterministic order
+    std::sort(pairs.begin(), pairs.end(), [](const CollisionPair &p, const CollisionPair &q) {
+        return p.first < q.first || (p.first == q.first && p.second < q.second);
+    });
+}
+
+
+void SpatialHash::Query(CollisionLayer layer, float min_x, float min_y, float max_x, float max_y, std::vector<int> &ids)
+{
+    ids.clear();
+    const std::vector<Entry> &entries = entries_[layer];
+    if (entries.empty()) {
+        return;
+    }
+
+    // Cells that the center of an object reaching into the rectangle can be in
+    float reach = max_radius_[layer];
+    float cell_min_x = floorf((min_x - reach) / cell_size_);
+    float cell_max_x = floorf((max_x + reach) / cell_size_);
+    float cell_min_y = floorf((min_y - reach) / cell_size_);
+    float cell_max_y = floorf((max_y + reach) / cell_size_);
+
+    // A rectangle covering more cells than there are objects is faster to
+    // check object by object
+    if ((cell_max_x - cell_min_x + 1.0f) * (cell_max_y - cell_min_y + 1.0f) > (float) entries.size()) {
+        for (int i = 0; i < entries.size(); i++) {
+            const Entry &e = entries[i];
+            if (e.x + e.radius >= min_x && e.x - e.radius <= max_x && e.y + e.radius >= min_y && e.y - e.radius <= max_y) {
+                ids.push_back(e.id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        return;
+    }
+
+    if (!built_[layer]) {
+        BuildLayer(layer);
+    }
+    const std::vector<Entry> &sorted = sorted_[layer];
+    const std::vector<int> &start = bucket_start_[layer];
+    for (int cy = (int) cell_min_y; cy <= (int) cell_max_y; cy++) {
+        for (int cx = (int) cell_min_x; cx <= (int) cell_max_x; cx++) {
+            int bucket = Bucket(cx, cy);
+            for (int j = start[bucket]; j < start[bucket + 1]; j++) {
+                const Entry &e = sorted[j];
+
+                // Different cells can share a bucket
+                if (e.cell_x != cx || e.cell_y != cy) {
+                    continue;
+                }
+
+                // Check if the bounds of the circle overlap the rectangle
+                if (e.x + e.radius >= min_x && e.x - e.radius <= max_x && e.y + e.radius >= min_y && e.y - e.radius <= max_y) {
+                    ids.push_back(e.id);
+                }
+            }
+        }
+    }
+
+    // Report the objects in the order they were inserted
+    std::sort(ids.begin(), ids.end());
+}
+
+} // namespace game
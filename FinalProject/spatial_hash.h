@@ -0,0 +1,109 @@
+#ifndef SPATIAL_HASH_H_
+#define SPATIAL_HASH_H_
+
+#include <vector>
+#include <math.h>
+#include <glm/glm.hpp>
+
+#include "job_system.h"
+
+namespace game {
+
+    // Collision layers that objects can be placed on
+    enum CollisionLayer {
+        LAYER_PLAYER = 0,
+        LAYER_ENEMY,
+        LAYER_COLLECTIBLE,
+        NUM_COLLISION_LAYERS
+    };
+
+    // Two objects (by the ids given on insertion) whose bounding circles overlap
+    struct CollisionPair {
+        int first;
+        int second;
+    };
+
+    /*
+        SpatialHash is a uniform grid broadphase for collision detection
+        Objects are hashed into grid cells by their center every frame, so
+        finding the pairs between two layers only looks at nearby cells
+        instead of testing every object against every other object
+    */
+    class SpatialHash {
+
+        public:
+            // Constructor
+            SpatialHash(void);
+
+            // Set the size of a grid cell and the number of hash buckets
+            // (rounded up to a power of two)
+            void Init(float cell_size, int num_buckets);
+
+            // Remove all objects, call once per frame before inserting
+            void Clear(void);
+
+            // Add an object with a bounding circle to a layer
+            void Insert(int id, CollisionLayer layer, const glm::vec3 &position, float radius);
+
+            // Add a set of objects stored as component arrays to a layer, with
+            // the array indices as ids and radius_scale * scale as radii
+            // The entries are filled in chunks on the job system
+            void InsertArrays(CollisionLayer layer, const float *pos_x, const float *pos_y, const float *scale, float radius_scale, int count, JobSystem *jobs);
+
+            // Find all pairs of objects from layer a and layer b whose
+            // bounding circles overlap. Pairs are sorted by id
+            void FindPairs(CollisionLayer a, CollisionLayer b, std::vector<CollisionPair> &pairs);
+
+            // Find the objects of a layer whose bounding circles reach into
+            // a rectangle. Ids are sorted
+            void Query(CollisionLayer layer, float min_x, float min_y, float max_x, float max_y, std::vector<int> &ids);
+
+            // Getters
+            inline float GetCellSize(void) { return cell_size_; }
+            inline int GetCount(CollisionLayer layer) { return (int) entries_[layer].size(); }
+
+        private:
+            // An object stored in the grid
+            struct Entry {
+                int id;
+                int cell_x;
+                int cell_y;
+                float x;
+                float y;
+                float radius;
+            };
+
+            // Size of a grid cell in world units
+            float cell_size_;
+
+            // Number of hash buckets (power of two) and its mask
+            int num_buckets_;
+            int bucket_mask_;
+
+            // Objects of each layer in insertion order
+            std::vector<Entry> entries_[NUM_COLLISION_LAYERS];
+
+            // Objects of each layer sorted by bucket, with the start of each
+            // bucket in the sorted array (built on demand)
+            std::vector<Entry> sorted_[NUM_COLLISION_LAYERS];
+            std::vector<int> bucket_start_[NUM_COLLISION_LAYERS];
+            std::vector<int> scratch_;
+            bool built_[NUM_COLLISION_LAYERS];
+
+            // Largest radius inserted in each layer
+            float max_radius_[NUM_COLLISION_LAYERS];
+
+            // Grid cell containing a world coordinate
+            inline int CellCoord(float v) { return (int) floorf(v / cell_size_); }
+
+            // Hash bucket of a grid cell
+            inline int Bucket(int cell_x, int cell_y) { return (int) (((unsigned int) cell_x * 73856093u) ^ ((unsigned int) cell_y * 19349663u)) & bucket_mask_; }
+
+            // Sort the objects of a layer into their buckets
+            void BuildLayer(CollisionLayer layer);
+
+    }; // class SpatialHash
+
+} // namespace game
+
+#endif // SPATIAL_HASH_H_
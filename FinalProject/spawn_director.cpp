@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <stdexcept>
+#include <string>
+
+#include "profiler.h"
+#include "spawn_director.h"
+
+namespace game {
+
+// Enemies placed per tick by default, a wave of a few thousand arrives in
+// about a second at 60 ticks per second
+const int spawn_count_budget_g = 64;
+
+// Enemies placed between two checks of a time budget
+const int spawn_batch_g = 32;
+
+SpawnDirector::SpawnDirector(void)
+{
+    // Initialize variables with default values
+    random_ = NULL;
+    count_budget_ = spawn_count_budget_g;
+    time_budget_ = 0.0;
+    num_reserved_ = 0;
+    num_waves_ = 0;
+    num_spawned_ = 0;
+    num_dropped_ = 0;
+    max_per_tick_ = 0;
+    num_busy_ticks_ = 0;
+}
+
+
+void SpawnDirector::Init(const SpawnWave *waves, int num_waves, Random *random)
+{
+    waves_.assign(waves, waves + num_waves);
+    next_start_.resize(num_waves);
+    for (int i = 0; i < num_waves; i++) {
+        if (waves[i].count < 0 || waves[i].period < 0.0 || waves[i].min_distance > waves[i].max_distance) {
+            throw(std::runtime_error(std::string("Invalid spawn wave ") + std::to_string(i)));
+        }
+        next_start_[i] = waves[i].start;
+    }
+    random_ = random;
+    pending_.clear();
+    num_reserved_ = 0;
+}
+
+
+void SpawnDirector::SetCountBudget(int count)
+{
+    if (count < 1) {
+        throw(std::runtime_error(std::string("Invalid spawn budget ") + std::to_string(count)));
+    }
+    count_budget_ = count;
+    time_budget_ = 0.0;
+}
+
+
+void SpawnDirector::SetTimeBudget(double microseconds)
+{
+    if (microseconds <= 0.0) {
+        throw(std::runtime_error(std::string("Invalid spawn time budget ") + std::to_string(microseconds)));
+    }
+    time_budget_ = microseconds;
+}
+
+
+int SpawnDirector::Update(double time, EntityStore &store, const glm::vec3 &center, int texture)
+{
+    // Start the waves that are due and keep slots for their enemies
+    // Whatever does not fit in the pool next to the live and kept ones is
+    // dropped now rather than trickling in later
+    for (int i = 0; i < waves_.size(); i++) {
+        while (time > next_start_[i]) {
+            const SpawnWave &wave = waves_[i];
+            int free = store.GetCapacity() - store.GetCount() - num_reserved_;
+            int count = std::min(wave.count, std::max(free, 0));
+            num_dropped_ += wave.count - count;
+            num_waves_++;
+            if (count > 0) {
+                PendingWave pending = { count, wave.min_distance, wave.max_distance };
+                pending_.push_back(pending);
+                num_reserved_ += count;
+            }
+            next_start_[i] = wave.period > 0.0 ? next_start_[i] + wave.period : DBL_MAX;
+        }
+    }
+    if (pending_.empty()) {
+        return 0;
+    }
+    PROFILE_SCOPE("Spawn batches");
+
+    // Place batches until the budget of the tick is spent, at least one
+    int spawned = 0;
+    if (time_budget_ > 0.0) {
+        auto start = std::chrono::steady_clock::now();
+        do {
+            spawned += SpawnBatch(spawn_batch_g, store, center, texture);
+        } while (!pending_.empty() &&
+                 std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() < time_budget_);
+    } else {
+        while (!pending_.empty() && spawned < count_budget_) {
+            spawned += SpawnBatch(count_budget_ - spawned, store, center, texture);
+        }
+    }
+
+    num_spawned_ += spawned;
+    max_per_tick_ = std::max(max_per_tick_, spawned);
+    num_busy_ticks_++;
+    return spawned;
+}
+
+
+int SpawnDirector::SpawnBatch(int count, EntityStore &store, const glm::vec3 &center, int texture)
+{
+    PendingWave &wave = pending_.front();
+    count = std::min(count, wave.remaining);
+
+    // Uniformly over the area of the ring: the square of the distance is
+    // spread evenly between the squares of its bounds
+    float min_sq = wave.min_distance * wave.min_distance;
+    float max_sq = wave.max_distance * wave.max_distance;
+    for (int i = 0; i < count; i++) {
+        float angle = 6.28318531f * random_->Float();
+        float distance = sqrtf(min_sq + (max_sq - min_sq) * random_->Float());
+        store.Acquire(center + glm::vec3(distance * cosf(angle), distance * sinf(angle), 0.0f), 1.0f, texture);
+    }
+
+    // Hand back the slots kept for the placed enemies
+    wave.remaining -= count;
+    num_reserved_ -= count;
+    if (wave.remaining == 0) {
+        pending_.pop_front();
+    }
+    return count;
+}
+
+} // namespace game
@@ -0,0 +1,106 @@
+#ifndef SPAWN_DIRECTOR_H_
+#define SPAWN_DIRECTOR_H_
+
+#include <deque>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "entity_store.h"
+#include "random.h"
+
+namespace game {
+
+    // A wave of enemies: when it comes, how many enemies it brings and how
+    // far from the player they appear. A wave with a period comes back
+    // every period seconds
+    struct SpawnWave {
+        double start;
+        double period;       // 0 to come once
+        int count;
+        float min_distance;
+        float max_distance;
+    };
+
+    /*
+        SpawnDirector brings the waves of enemies into a store. When a wave
+        starts, its enemies are given slots of the pool right away, so that
+        a wave is either placed whole or told up front how many did not
+        fit. They are then placed in batches over the following ticks,
+        within a budget per tick (a number of enemies, or a time), so that a
+        wave of thousands arrives over a few frames instead of stalling one
+
+        Spawns are placed on a ring around the player, in random directions
+        drawn from the world's random numbers
+    */
+    class SpawnDirector {
+
+        public:
+            // Constructor
+            SpawnDirector(void);
+
+            // Set the waves and the random numbers that place the spawns
+            void Init(const SpawnWave *waves, int num_waves, Random *random);
+
+            // Spawn at most this many enemies per tick (the default)
+            void SetCountBudget(int count);
+            inline int GetCountBudget(void) { return count_budget_; }
+
+            // Spawn for at most this many microseconds per tick, in whole
+            // batches. How far a wave gets then depends on the machine, so
+            // a game spawning this way does not play the same way twice
+            void SetTimeBudget(double microseconds);
+
+            // Whether the spawns of a game depend only on its random numbers
+            inline bool IsRepeatable(void) { return time_budget_ <= 0.0; }
+
+            // Start the waves due at a time and place the next batches of
+            // enemies around a center, with a texture
+            // Returns the number of enemies placed
+            int Update(double time, EntityStore &store, const glm::vec3 &center, int texture);
+
+            // Statistics
+            inline int GetNumPending(void) { return num_reserved_; }
+            inline long long GetNumWaves(void) { return num_waves_; }
+            inline long long GetNumSpawned(void) { return num_spawned_; }
+            inline long long GetNumDropped(void) { return num_dropped_; }
+            inline int GetMaxPerTick(void) { return max_per_tick_; }
+            inline long long GetNumBusyTicks(void) { return num_busy_ticks_; }
+
+        private:
+            // Enemies of a started wave still to be placed
+            struct PendingWave {
+                int remaining;
+                float min_distance;
+                float max_distance;
+            };
+
+            // Waves and the next time each one comes
+            std::vector<SpawnWave> waves_;
+            std::vector<double> next_start_;
+
+            // Random numbers of the world
+            Random *random_;
+
+            // Budget per tick
+            int count_budget_;
+            double time_budget_;
+
+            // Started waves in order, and the slots kept for them
+            std::deque<PendingWave> pending_;
+            int num_reserved_;
+
+            // Statistics
+            long long num_waves_;
+            long long num_spawned_;
+            long long num_dropped_;
+            int max_per_tick_;
+            long long num_busy_ticks_;
+
+            // Place up to count enemies of the oldest started wave
+            int SpawnBatch(int count, EntityStore &store, const glm::vec3 &center, int texture);
+
+    }; // class SpawnDirector
+
+} // namespace game
+
+#endif // SPAWN_DIRECTOR_H_
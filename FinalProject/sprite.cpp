@@ -2,6 +2,7 @@
 #include <string>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_state.h"
 #include "sprite.h"
 
 namespace game {
@@ -9,6 +10,7 @@ namespace game {
 Sprite::Sprite(void) : Geometry()
 {
     // Initialize variables with default values
+    vao_ = 0;
     vbo_ = 0;
     ebo_ = 0;
     size_ = 0;
@@ -38,16 +40,31 @@ void Sprite::CreateGeometry(void){
         2, 3, 0  // t2
     };
 
+    // Create the vertex array that records the buffers and attributes below
+    glGenVertexArrays(1, &vao_);
+    GLState::BindVertexArray(vao_);
+
     // Create buffer for vertices
     glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, vbo_);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertex), vertex, GL_STATIC_DRAW);
 
     // Create buffer for faces (index buffer)
     glGenBuffers(1, &ebo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(face), face, GL_STATIC_DRAW);
 
+    // Set attributes for shaders
+    // Should be consistent with how we created the buffers for the square
+    glVertexAttribPointer(ATTRIB_VERTEX, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(GLfloat), 0);
+    glEnableVertexAttribArray(ATTRIB_VERTEX);
+
+    glVertexAttribPointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(GLfloat), (void *)(2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+
+    glVertexAttribPointer(ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(GLfloat), (void *)(5 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(ATTRIB_UV);
+
     // Set number of elements in array buffer (6 in this case)
     size_ = sizeof(face) / sizeof(GLuint);
 }
@@ -57,27 +74,12 @@ void Sprite::SetGeometry(GLuint shader_program)
 {
 
     // No blending
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-    glDisable(GL_BLEND);
-
-    // Bind buffers
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-
-    // Set attributes for shaders
-    // Should be consistent with how we created the buffers for the square
-    GLint vertex_att = glGetAttribLocation(shader_program, "vertex");
-    glVertexAttribPointer(vertex_att, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(GLfloat), 0);
-    glEnableVertexAttribArray(vertex_att);
-
-    GLint color_att = glGetAttribLocation(shader_program, "color");
-    glVertexAttribPointer(color_att, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(GLfloat), (void *)(2 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(color_att);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthFunc(GL_LESS);
+    GLState::Disable(GL_BLEND);
 
-    GLint tex_att = glGetAttribLocation(shader_program, "uv");
-    glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(GLfloat), (void *)(5 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(tex_att);
+    // Bind the vertex array, the buffers and attributes were set up in CreateGeometry()
+    GLState::BindVertexArray(vao_);
 }
 
 } // namespace game
@@ -0,0 +1,124 @@
+#include <stdexcept>
+#include <stddef.h>
+
+#include "gl_state.h"
+#include "sprite_batch.h"
+
+namespace game {
+
+SpriteBatch::SpriteBatch(void)
+{
+    // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    geometry_ = NULL;
+    shader_ = NULL;
+    atlas_ = NULL;
+    instance_vbo_ = 0;
+    capacity_ = 0;
+    draw_calls_ = 0;
+}
+
+
+SpriteBatch::~SpriteBatch()
+{
+
+    Release();
+}
+
+
+void SpriteBatch::Release(void)
+{
+    // Nothing was created without an OpenGL context (headless)
+    if (instance_vbo_) {
+        glDeleteBuffers(1, &instance_vbo_);
+        instance_vbo_ = 0;
+        capacity_ = 0;
+    }
+}
+
+
+void SpriteBatch::Init(Geometry *geom, Shader *shader)
+{
+    geometry_ = geom;
+    shader_ = shader;
+
+    // Look up the shader inputs once
+    regions_loc_ = shader_->GetUniformLocation("atlas_regions");
+
+    // Create the instance buffer, it is resized when the first frame is drawn
+    glGenBuffers(1, &instance_vbo_);
+    capacity_ = 0;
+
+    // Record the instance attributes in the geometry's vertex array
+    SetInstanceAttributes();
+}
+
+
+void SpriteBatch::SetAtlas(TextureAtlas *atlas)
+{
+    if (atlas->GetNumRegions() > max_atlas_regions_g) {
+        throw(std::runtime_error(std::string("Too many texture atlas regions: ") + std::to_string(atlas->GetNumRegions())));
+    }
+    atlas_ = atlas;
+
+    // The region table does not change, so it only has to be set once
+    shader_->Enable();
+    shader_->SetUniform4fv(regions_loc_, atlas->GetNumRegions(), atlas->GetRegions());
+}
+
+
+void SpriteBatch::Draw(const std::vector<SpriteInstance> &instances)
+{
+    draw_calls_ = 0;
+    if (instances.empty()) {
+        return;
+    }
+
+    // Upload the instances, growing the buffer if needed
+    // Orphaning the old storage lets the driver keep using it for the
+    // previous frame while we fill the new one
+    GLState::BindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    if (instances.size() > capacity_) {
+        capacity_ = 2 * (int) instances.size();
+    }
+    glBufferData(GL_ARRAY_BUFFER, capacity_ * sizeof(SpriteInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(SpriteInstance), instances.data());
+
+    // Set up the shader
+    shader_->Enable();
+
+    // Set up the geometry, its vertex array also holds the instance attributes
+    geometry_->SetGeometry(shader_->GetShaderProgram());
+
+    // Bind the atlas holding every sprite's image
+    GLState::BindTexture(GL_TEXTURE_2D, atlas_->GetTexture());
+
+    // Draw all sprites
+    glDrawElementsInstanced(GL_TRIANGLES, geometry_->GetSize(), GL_UNSIGNED_INT, 0, (GLsizei) instances.size());
+    draw_calls_++;
+}
+
+
+void SpriteBatch::SetInstanceAttributes(void)
+{
+    GLState::BindVertexArray(geometry_->GetVertexArray());
+    GLState::BindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+
+    // Position of the sprite, advances once per instance
+    glVertexAttribPointer(ATTRIB_INSTANCE_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void *) offsetof(SpriteInstance, position));
+    glVertexAttribDivisor(ATTRIB_INSTANCE_POSITION, 1);
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_POSITION);
+
+    // Scale of the sprite, advances once per instance
+    glVertexAttribPointer(ATTRIB_INSTANCE_SCALE, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void *) offsetof(SpriteInstance, scale));
+    glVertexAttribDivisor(ATTRIB_INSTANCE_SCALE, 1);
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_SCALE);
+
+    // Atlas region of the sprite, advances once per instance
+    glVertexAttribPointer(ATTRIB_INSTANCE_REGION, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void *) offsetof(SpriteInstance, region));
+    glVertexAttribDivisor(ATTRIB_INSTANCE_REGION, 1);
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_REGION);
+}
+
+} // namespace game
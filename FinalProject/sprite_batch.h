@@ -0,0 +1,80 @@
+#ifndef SPRITE_BATCH_H_
+#define SPRITE_BATCH_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "shader.h"
+#include "geometry.h"
+#include "texture_atlas.h"
+
+namespace game {
+
+    // Per-instance data of a sprite, as stored in the instance buffer
+    struct SpriteInstance {
+        glm::vec3 position;
+        float scale;
+        float region;
+    };
+
+    // Largest number of atlas regions the sprite shader can hold
+    // (size of the atlas_regions array in the vertex shader)
+    const int max_atlas_regions_g = 32;
+
+    /*
+        SpriteBatch draws all the sprites of a frame with instanced
+        rendering: the shared sprite geometry is drawn once, with the
+        position, scale and atlas region of every sprite taken from an
+        instance buffer. The sprites are recorded elsewhere (see RenderFrame),
+        the batch only uploads and draws them
+    */
+    class SpriteBatch {
+
+        public:
+            // Constructor and destructor
+            SpriteBatch(void);
+            ~SpriteBatch();
+
+            // Create the instance buffer (called once)
+            void Init(Geometry *geom, Shader *shader);
+
+            // Delete the instance buffer, while the OpenGL context is still
+            // there (the destructor does it otherwise)
+            void Release(void);
+
+            // Use a texture atlas for all sprites, once it has been built
+            void SetAtlas(TextureAtlas *atlas);
+
+            // Draw a list of sprites with a single draw call, in their order
+            // in the list. The camera comes from the Camera uniform buffer
+            void Draw(const std::vector<SpriteInstance> &instances);
+
+            // Number of draw calls issued by the last Draw()
+            inline int GetDrawCalls(void) { return draw_calls_; }
+
+        private:
+            // Geometry, shader and texture shared by all sprites
+            Geometry *geometry_;
+            Shader *shader_;
+            TextureAtlas *atlas_;
+
+            // Location of the shader's region table
+            GLint regions_loc_;
+
+            // Buffer holding the instance data and its size in instances
+            GLuint instance_vbo_;
+            int capacity_;
+
+            // Statistics
+            int draw_calls_;
+
+            // Add the instance attributes to the geometry's vertex array
+            void SetInstanceAttributes(void);
+
+    }; // class SpriteBatch
+
+} // namespace game
+
+#endif // SPRITE_BATCH_H_
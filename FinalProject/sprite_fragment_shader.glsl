@@ -1,20 +1,23 @@
 // Source code of fragment shader
-#version 130
+#version 140
 
 // Attributes passed from the vertex shader
 in vec4 color_interp;
 in vec2 uv_interp;
 
-// Texture sampler
+// Texture sampler (the texture atlas)
 uniform sampler2D onetex;
 
+// Output color
+out vec4 frag_color;
+
 void main()
 {
     // Sample texture
-    vec4 color = texture2D(onetex, uv_interp);
+    vec4 color = texture(onetex, uv_interp);
 
     // Assign color to fragment
-    gl_FragColor = vec4(color.r, color.g, color.b, color.a);
+    frag_color = vec4(color.r, color.g, color.b, color.a);
 
     // Check for transparency
     if(color.a < 1.0)
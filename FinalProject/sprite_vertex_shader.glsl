@@ -1,14 +1,23 @@
 // Source code of vertex shader
-#version 130
+#version 140
 
 // Vertex buffer
 in vec2 vertex;
 in vec3 color;
 in vec2 uv;
 
-// Uniform (global) buffer
-uniform mat4 transformation_matrix;
-uniform mat4 view_matrix;
+// Instance buffer (one entry per sprite)
+in vec3 instance_position;
+in float instance_scale;
+in float instance_region;
+
+// Camera data, one uniform buffer shared by all draws of a frame
+layout(std140) uniform Camera {
+    mat4 view_matrix;
+};
+
+// Texture coordinates of each image in the texture atlas (u, v, width, height)
+uniform vec4 atlas_regions[32];
 
 // Attributes forwarded to the fragment shader
 out vec4 color_interp;
@@ -16,11 +25,12 @@ out vec2 uv_interp;
 
 void main()
 {
-    // Transform vertex
-    vec4 vertex_pos = vec4(vertex, 0.0, 1.0);
-    gl_Position = view_matrix * transformation_matrix * vertex_pos;
+    // Transform vertex: scale the sprite and move it to its position
+    vec4 vertex_pos = vec4(vertex * instance_scale, 0.0, 1.0) + vec4(instance_position, 0.0);
+    gl_Position = view_matrix * vertex_pos;
     
     // Pass attributes to fragment shader
     color_interp = vec4(color, 1.0);
-    uv_interp = uv;
+    vec4 region = atlas_regions[int(instance_region)];
+    uv_interp = region.xy + uv * region.zw;
 }
@@ -0,0 +1,580 @@
+// Stress benchmark of the simulation at large entity counts
+//
+//   StressBenchmark [--sizes 1000,10000,...] [--threads 1,2,...] [--ticks n]
+//                   [--csv file] [--json file] [--baseline file]
+//
+// The game's waves fill its enemy pool only late in a run, so this builds
+// synthetic worlds with the given numbers of enemies and as many
+// collectibles, spread at a constant density around a player, and runs
+// the same systems over them as a game tick: the enemy update, the
+// broadphase and distance tests of the collisions, and the recording of
+// the sprites the game camera sees. Sizes past the pool show how the
+// systems scale beyond what the game holds. Every world size runs with
+// every thread count to give the scaling curve, then each subsystem is
+// timed on its own
+//
+// Results are printed as a table and can be written as CSV or JSON. A CSV
+// written by an earlier run can be passed as the baseline, to print the
+// change of every measurement against it
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <math.h>
+#include <random>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "entity_store.h"
+#include "entity_systems.h"
+#include "job_system.h"
+#include "render_queue.h"
+#include "simd_kernels.h"
+#include "spatial_hash.h"
+
+// Defaults
+const int stress_sizes_g[] = { 1000, 10000, 100000, 1000000 };
+const double stress_delta_time_g = 1.0 / 60.0;
+const unsigned int stress_seed_g = 12345;
+
+// Entities per world unit squared, about what the game shows on screen
+const float stress_density_g = 0.25f;
+
+// Zoom of the game camera, which is centered on the player
+const float stress_camera_zoom_g = 0.25f;
+
+// Ticks run for a world of n entities: about the same total work for every
+// size, within bounds
+const long long stress_entity_ticks_g = 20000000;
+const int stress_min_ticks_g = 10;
+const int stress_max_ticks_g = 2000;
+
+// Untimed ticks before measuring, to fault in the arrays and warm the caches
+const int stress_warmup_ticks_g = 3;
+
+// Same chunk size and ranges as the game
+const int stress_grain_g = 2048;
+const float stress_chase_gain_g = 0.1f;
+const float stress_chase_range_g = 1.5f;
+
+
+// One measurement
+struct Result {
+    std::string suite;
+    std::string name;
+    int entities;
+    int threads;
+    int iterations;
+    double ms;
+};
+
+
+// A synthetic world: a player in the middle of enemies and collectibles
+struct World {
+    game::EntityStore enemies;
+    game::EntityStore collectibles;
+    glm::vec3 player;
+    game::SpatialHash broadphase;
+    std::vector<float> distances;
+    std::vector<game::CollisionPair> pairs;
+    game::RenderFrame frame;
+    game::ViewRect view;
+    std::vector<int> candidates;
+};
+
+
+// Fill a world with n enemies and n collectibles at random positions
+// The world grows with n so that the density, and with it the number of
+// objects per broadphase cell, stays the same
+static void BuildWorld(World &world, int n)
+{
+    std::mt19937 rng(stress_seed_g);
+    float half_size = 0.5f * sqrtf(2.0f * n / stress_density_g);
+    std::uniform_real_distribution<float> coord(-half_size, half_size);
+
+    world.enemies.Init(n);
+    world.collectibles.Init(n);
+    for (int i = 0; i < n; i++) {
+        glm::vec3 position(coord(rng), coord(rng), 0.0f);
+        world.enemies.Acquire(position, 1.0f, i % 4);
+        world.enemies.SetChasing(i, (rng() % 8) == 0);
+    }
+    for (int i = 0; i < n; i++) {
+        world.collectibles.Acquire(glm::vec3(coord(rng), coord(rng), 0.0f), 1.0f, 4);
+    }
+    world.player = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    // About one bucket per two objects, like a well sized hash table
+    world.broadphase.Init(2.0f, n);
+    world.distances.assign(n, 0.0f);
+    world.frame.sprites.clear();
+    world.frame.sprites.reserve(2 * n);
+    world.view = game::GetViewRect(glm::scale(glm::mat4(1.0f), glm::vec3(stress_camera_zoom_g, stress_camera_zoom_g, stress_camera_zoom_g)));
+}
+
+
+// Enemy update of a tick, as in Game::UpdateEntities
+static void UpdateWorld(World &world, game::JobSystem &jobs, float delta_time)
+{
+    game::EntityStore &enemies = world.enemies;
+    float cos_rot = cosf(0.5f * delta_time);
+    float sin_rot = sinf(0.5f * delta_time);
+    glm::vec3 target = world.player;
+
+    enemies.SavePositions();
+    world.collectibles.SavePositions();
+    jobs.ParallelFor(0, enemies.GetSize(), stress_grain_g, [&enemies, cos_rot, sin_rot, target, delta_time](int begin, int end) {
+        game::PatrolSystem(enemies, cos_rot, sin_rot, begin, end);
+        game::ChaseSystem(enemies, target, stress_chase_gain_g, begin, end);
+        game::IntegrateSystem(enemies, delta_time, begin, end);
+    });
+    game::IntegrateSystem(world.collectibles, delta_time);
+}
+
+
+// Collisions of a tick, as in Game::Collide but without removing anything,
+// so that the world keeps its size
+static void CollideWorld(World &world, game::JobSystem &jobs)
+{
+    game::EntityStore &enemies = world.enemies;
+    game::EntityStore &collectibles = world.collectibles;
+
+    // Rebuild the broadphase
+    world.broadphase.Clear();
+    world.broadphase.Insert(0, game::LAYER_PLAYER, world.player, stress_chase_range_g);
+    world.broadphase.InsertArrays(game::LAYER_ENEMY, enemies.GetPositionX(), enemies.GetPositionY(), enemies.GetScale(), 0.5f, enemies.GetSize(), &jobs);
+    world.broadphase.InsertArrays(game::LAYER_COLLECTIBLE, collectibles.GetPositionX(), collectibles.GetPositionY(), collectibles.GetScale(), 0.5f, collectibles.GetSize(), &jobs);
+
+    // Distances to the player and the enemies that start chasing it
+    float *distances = world.distances.data();
+    glm::vec3 player = world.player;
+    jobs.ParallelFor(0, enemies.GetSize(), stress_grain_g, [&enemies, player, distances](int begin, int end) {
+        game::DistanceSystem(enemies, player, distances, begin, end);
+    });
+    world.broadphase.FindPairs(game::LAYER_PLAYER, game::LAYER_ENEMY, world.pairs);
+    for (int p = 0; p < world.pairs.size(); p++) {
+        int enemy = world.pairs[p].second;
+        if (world.distances[enemy] < stress_chase_range_g * stress_chase_range_g) {
+            enemies.SetChasing(enemy, true);
+        }
+    }
+
+    // Collectibles in reach of the player
+    game::DistanceSystem(collectibles, player, distances);
+    world.broadphase.FindPairs(game::LAYER_PLAYER, game::LAYER_COLLECTIBLE, world.pairs);
+}
+
+
+// Sprites of a frame seen from a view, as in Game::Render: the candidates
+// come from the broadphase of the last collision phase
+static void RecordWorld(World &world, const game::ViewRect &view)
+{
+    world.frame.sprites.clear();
+    world.frame.num_culled = 0;
+    float margin = 1.0f;
+    world.broadphase.Query(game::LAYER_ENEMY, view.min_x - margin, view.min_y - margin, view.max_x + margin, view.max_y + margin, world.candidates);
+    game::RenderSystem(world.enemies, &world.frame, 0.5f, view, world.candidates);
+    world.broadphase.Query(game::LAYER_COLLECTIBLE, view.min_x - margin, view.min_y - margin, view.max_x + margin, view.max_y + margin, world.candidates);
+    game::RenderSystem(world.collectibles, &world.frame, 0.5f, view, world.candidates);
+}
+
+
+// Sprites of a frame, testing every entity against the view
+static void RecordWorldScan(World &world, const game::ViewRect &view)
+{
+    world.frame.sprites.clear();
+    world.frame.num_culled = 0;
+    game::RenderSystem(world.enemies, &world.frame, 0.5f, view);
+    game::RenderSystem(world.collectibles, &world.frame, 0.5f, view);
+}
+
+
+// Sum of the enemy positions, to check that every thread count computes
+// the same world
+static double Checksum(World &world)
+{
+    double sum = 0.0;
+    for (int i = 0; i < world.enemies.GetSize(); i++) {
+        sum += world.enemies.GetPositionX()[i] + world.enemies.GetPositionY()[i];
+    }
+    return sum;
+}
+
+
+// Milliseconds since a time point
+static double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+// Milliseconds per iteration of a function
+template <typename F>
+static double TimeIterations(int iterations, F body)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        body();
+    }
+    return ElapsedMs(start) / iterations;
+}
+
+
+// Parse a comma separated list of positive numbers
+static std::vector<int> ParseList(const std::string &text)
+{
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int value = atoi(item.c_str());
+        if (value > 0) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+
+// Key of a measurement, to match it with the baseline
+static std::string ResultKey(const std::string &suite, const std::string &name, int entities, int threads)
+{
+    std::ostringstream key;
+    key << suite << "," << name << "," << entities << "," << threads;
+    return key.str();
+}
+
+
+// Read the milliseconds of the measurements of an earlier CSV report
+static std::map<std::string, double> ReadBaseline(const std::string &file_name)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream in(file_name.c_str());
+    if (!in) {
+        std::cerr << "Could not read the baseline " << file_name << std::endl;
+        return baseline;
+    }
+
+    // Columns: suite,name,entities,threads,iterations,ms_per_iteration,...
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() >= 6) {
+            baseline[ResultKey(fields[0], fields[1], atoi(fields[2].c_str()), atoi(fields[3].c_str()))] = atof(fields[5].c_str());
+        }
+    }
+    return baseline;
+}
+
+
+// Time of the same measurement with one thread, for the speedup
+static double SingleThreadMs(const std::vector<Result> &results, const Result &result)
+{
+    for (int i = 0; i < results.size(); i++) {
+        const Result &other = results[i];
+        if (other.suite == result.suite && other.name == result.name && other.entities == result.entities && other.threads == 1) {
+            return other.ms;
+        }
+    }
+    return 0.0;
+}
+
+
+static void WriteCsv(const std::string &file_name, const std::vector<Result> &results)
+{
+    std::ofstream out(file_name.c_str());
+    if (!out) {
+        std::cerr << "Could not write " << file_name << std::endl;
+        return;
+    }
+    out << "suite,name,entities,threads,iterations,ms_per_iteration,entities_per_second,speedup" << std::endl;
+    out << std::setprecision(9);
+    for (int i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        double single = SingleThreadMs(results, r);
+        out << r.suite << "," << r.name << "," << r.entities << "," << r.threads << "," << r.iterations << ","
+            << r.ms << "," << r.entities * 1000.0 / r.ms << "," << (single > 0.0 ? single / r.ms : 1.0) << std::endl;
+    }
+}
+
+
+static void WriteJson(const std::string &file_name, const std::vector<Result> &results)
+{
+    std::ofstream out(file_name.c_str());
+    if (!out) {
+        std::cerr << "Could not write " << file_name << std::endl;
+        return;
+    }
+    out << std::setprecision(9);
+    out << "{\"simd\":\"" << game::GetSimdLevelName(game::GetSimdLevel()) << "\",\"hardware_threads\":" << std::thread::hardware_concurrency()
+        << ",\"results\":[" << std::endl;
+    for (int i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        double single = SingleThreadMs(results, r);
+        out << "{\"suite\":\"" << r.suite << "\",\"name\":\"" << r.name << "\",\"entities\":" << r.entities << ",\"threads\":" << r.threads
+            << ",\"iterations\":" << r.iterations << ",\"ms_per_iteration\":" << r.ms << ",\"entities_per_second\":" << r.entities * 1000.0 / r.ms
+            << ",\"speedup\":" << (single > 0.0 ? single / r.ms : 1.0) << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "]}" << std::endl;
+}
+
+
+// Run the game systems over a world of n enemies with a number of threads
+static void RunTicks(int n, int threads, int ticks, std::vector<Result> &results, double &checksum)
+{
+    game::JobSystem jobs;
+    jobs.Init(threads);
+    World world;
+    BuildWorld(world, n);
+
+    // Warm up, then time each phase over the ticks
+    float dt = (float) stress_delta_time_g;
+    for (int t = 0; t < stress_warmup_ticks_g; t++) {
+        UpdateWorld(world, jobs, dt);
+        CollideWorld(world, jobs);
+        RecordWorld(world, world.view);
+    }
+    double update_ms = 0.0;
+    double collide_ms = 0.0;
+    double render_ms = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; t++) {
+        auto phase = std::chrono::steady_clock::now();
+        UpdateWorld(world, jobs, dt);
+        update_ms += ElapsedMs(phase);
+
+        phase = std::chrono::steady_clock::now();
+        CollideWorld(world, jobs);
+        collide_ms += ElapsedMs(phase);
+
+        phase = std::chrono::steady_clock::now();
+        RecordWorld(world, world.view);
+        render_ms += ElapsedMs(phase);
+    }
+    double tick_ms = ElapsedMs(start);
+
+    Result result = { "tick", "update", n, jobs.GetNumWorkers(), ticks, update_ms / ticks };
+    results.push_back(result);
+    result.name = "collide";
+    result.ms = collide_ms / ticks;
+    results.push_back(result);
+    result.name = "render";
+    result.ms = render_ms / ticks;
+    results.push_back(result);
+    result.name = "total";
+    result.ms = tick_ms / ticks;
+    results.push_back(result);
+    checksum = Checksum(world);
+}
+
+
+// Time every subsystem on its own over a world of n enemies
+static void RunMicro(int n, int threads, int iterations, std::vector<Result> &results)
+{
+    game::JobSystem jobs;
+    jobs.Init(threads);
+    World world;
+    BuildWorld(world, n);
+    Result result = { "micro", "", n, jobs.GetNumWorkers(), iterations, 0.0 };
+
+    // Enemy update with the kernels of each instruction set, on one thread
+    game::SimdLevel level = game::GetSimdLevel();
+    float dt = (float) stress_delta_time_g;
+    float cos_rot = cosf(0.5f * dt);
+    float sin_rot = sinf(0.5f * dt);
+    for (int l = 0; l < game::NUM_SIMD_LEVELS; l++) {
+        if (!game::SetSimdLevel((game::SimdLevel) l)) {
+            continue;
+        }
+        result.name = std::string("kernels_") + game::GetSimdLevelName((game::SimdLevel) l);
+        result.threads = 1;
+        result.ms = TimeIterations(iterations, [&world, cos_rot, sin_rot, dt]() {
+            game::PatrolSystem(world.enemies, cos_rot, sin_rot);
+            game::ChaseSystem(world.enemies, world.player, stress_chase_gain_g);
+            game::IntegrateSystem(world.enemies, dt);
+        });
+        results.push_back(result);
+    }
+    game::SetSimdLevel(level);
+    result.threads = jobs.GetNumWorkers();
+
+    // Cost of spreading a trivial loop over the workers
+    std::vector<float> values(n, 1.0f);
+    float *data = values.data();
+    result.name = "parallel_for";
+    result.ms = TimeIterations(iterations, [&jobs, n, data]() {
+        jobs.ParallelFor(0, n, stress_grain_g, [data](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                data[i] = data[i] * 0.5f + 0.5f;
+            }
+        });
+    });
+    results.push_back(result);
+
+    // Building the broadphase from the component arrays
+    game::EntityStore &enemies = world.enemies;
+    game::EntityStore &collectibles = world.collectibles;
+    result.name = "broadphase_insert";
+    result.ms = TimeIterations(iterations, [&world, &enemies, &collectibles, &jobs]() {
+        world.broadphase.Clear();
+        world.broadphase.InsertArrays(game::LAYER_ENEMY, enemies.GetPositionX(), enemies.GetPositionY(), enemies.GetScale(), 0.5f, enemies.GetSize(), &jobs);
+        world.broadphase.InsertArrays(game::LAYER_COLLECTIBLE, collectibles.GetPositionX(), collectibles.GetPositionY(), collectibles.GetScale(), 0.5f, collectibles.GetSize(), &jobs);
+    });
+    results.push_back(result);
+
+    // Every overlapping enemy and collectible, the worst case of the
+    // broadphase (the game only queries around the player), on one thread
+    game::JobSystem serial;
+    serial.Init(1);
+    result.name = "broadphase_pairs";
+    result.threads = 1;
+    result.ms = TimeIterations(iterations, [&world, &serial]() {
+        world.broadphase.Clear();
+        world.broadphase.Insert(0, game::LAYER_PLAYER, world.player, stress_chase_range_g);
+        world.broadphase.InsertArrays(game::LAYER_ENEMY, world.enemies.GetPositionX(), world.enemies.GetPositionY(), world.enemies.GetScale(), 0.5f, world.enemies.GetSize(), &serial);
+        world.broadphase.InsertArrays(game::LAYER_COLLECTIBLE, world.collectibles.GetPositionX(), world.collectibles.GetPositionY(), world.collectibles.GetScale(), 0.5f, world.collectibles.GetSize(), &serial);
+        world.broadphase.FindPairs(game::LAYER_ENEMY, game::LAYER_COLLECTIBLE, world.pairs);
+    });
+    results.push_back(result);
+
+    // Recording the sprites of a frame through the game camera, with the
+    // broadphase and by testing every entity, and of the whole world for
+    // comparison
+    CollideWorld(world, jobs);
+    game::ViewRect everything = { -FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX };
+    result.name = "render_culled";
+    result.threads = 1;
+    result.ms = TimeIterations(iterations, [&world]() { RecordWorld(world, world.view); });
+    results.push_back(result);
+    result.name = "render_scan";
+    result.ms = TimeIterations(iterations, [&world]() { RecordWorldScan(world, world.view); });
+    results.push_back(result);
+    result.name = "render_unculled";
+    result.ms = TimeIterations(iterations, [&world, &everything]() { RecordWorldScan(world, everything); });
+    results.push_back(result);
+
+    // Removing a tenth of the enemies through their handles and adding them
+    // back, as waves of spawns and kills would
+    std::vector<game::EntityHandle> handles;
+    result.name = "entity_churn";
+    result.ms = TimeIterations(iterations, [&enemies, &handles, n]() {
+        handles.clear();
+        for (int i = 0; i < n; i += 10) {
+            handles.push_back(enemies.GetHandle(i));
+        }
+        for (int h = 0; h < handles.size(); h++) {
+            enemies.Release(handles[h]);
+        }
+        enemies.Flush();
+        for (int h = 0; h < handles.size(); h++) {
+            enemies.Acquire(glm::vec3((float) h, 0.0f, 0.0f), 1.0f, 0);
+        }
+    });
+    results.push_back(result);
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse command line options
+    std::vector<int> sizes(stress_sizes_g, stress_sizes_g + sizeof(stress_sizes_g) / sizeof(stress_sizes_g[0]));
+    std::vector<int> thread_counts;
+    int ticks = 0;
+    std::string csv_file;
+    std::string json_file;
+    std::string baseline_file;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes = ParseList(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            thread_counts = ParseList(argv[++i]);
+        } else if (arg == "--ticks" && i + 1 < argc) {
+            ticks = atoi(argv[++i]);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_file = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baseline_file = argv[++i];
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // Powers of two up to one thread per core by default
+    if (thread_counts.empty()) {
+        int cores = std::max(1, (int) std::thread::hardware_concurrency());
+        for (int t = 1; t < cores; t *= 2) {
+            thread_counts.push_back(t);
+        }
+        thread_counts.push_back(cores);
+    }
+
+    std::cout << "Stress benchmark (" << game::GetSimdLevelName(game::GetSimdLevel()) << " kernels, "
+              << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    std::vector<Result> results;
+    for (int s = 0; s < sizes.size(); s++) {
+        int n = sizes[s];
+        int size_ticks = ticks > 0 ? ticks : (int) std::min<long long>(stress_max_ticks_g, std::max<long long>(stress_min_ticks_g, stress_entity_ticks_g / n));
+
+        // Every thread count must end up with the same world
+        double reference = 0.0;
+        for (int t = 0; t < thread_counts.size(); t++) {
+            double checksum = 0.0;
+            RunTicks(n, thread_counts[t], size_ticks, results, checksum);
+            if (t == 0) {
+                reference = checksum;
+            } else if (checksum != reference) {
+                std::cerr << "  " << n << " enemies with " << thread_counts[t] << " threads: RESULTS DIFFER FROM " << thread_counts[0] << " THREADS" << std::endl;
+            }
+        }
+        RunMicro(n, thread_counts.back(), size_ticks, results);
+    }
+
+    // Print the report, with the change to the baseline if there is one
+    std::map<std::string, double> baseline;
+    if (!baseline_file.empty()) {
+        baseline = ReadBaseline(baseline_file);
+    }
+    std::cout << std::left << std::setw(7) << "suite" << std::setw(19) << "name" << std::right << std::setw(9) << "entities"
+              << std::setw(8) << "threads" << std::setw(12) << "ms/iter" << std::setw(14) << "entities/s" << std::setw(9) << "speedup"
+              << (baseline.empty() ? "" : "  vs baseline") << std::endl;
+    for (int i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        double single = SingleThreadMs(results, r);
+        std::cout << std::left << std::setw(7) << r.suite << std::setw(19) << r.name << std::right << std::setw(9) << r.entities
+                  << std::setw(8) << r.threads << std::fixed << std::setprecision(4) << std::setw(12) << r.ms
+                  << std::scientific << std::setprecision(3) << std::setw(14) << r.entities * 1000.0 / r.ms
+                  << std::fixed << std::setprecision(2) << std::setw(8) << (single > 0.0 ? single / r.ms : 1.0) << "x";
+        std::map<std::string, double>::iterator old = baseline.find(ResultKey(r.suite, r.name, r.entities, r.threads));
+        if (old != baseline.end() && old->second > 0.0) {
+            std::cout << std::showpos << std::setw(10) << (r.ms / old->second - 1.0) * 100.0 << "%" << std::noshowpos;
+        }
+        std::cout << std::endl;
+    }
+
+    if (!csv_file.empty()) {
+        WriteCsv(csv_file, results);
+    }
+    if (!json_file.empty()) {
+        WriteJson(json_file, results);
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string.h>
+#include <SOIL/SOIL.h>
+
+#include "gl_state.h"
+#include "profiler.h"
+#include "texture_atlas.h"
+
+namespace game {
+
+// Transparent border around each region, so that filtering never mixes
+// two neighbouring images
+const int atlas_padding_g = 1;
+
+// Minimum width of the atlas in pixels
+const int atlas_min_width_g = 1024;
+
+
+// Read the size of a PNG image from its header, without decoding it
+// Returns false if the file is not a PNG image
+static bool ReadPngSize(const std::string &fname, int &width, int &height)
+{
+    std::ifstream f(fname.c_str(), std::ios::binary);
+    unsigned char header[24];
+    if (!f.read((char *) header, sizeof(header))) {
+        return false;
+    }
+
+    // Signature followed by the IHDR chunk, which holds the size
+    const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    if (memcmp(header, signature, 8) != 0 || memcmp(header + 12, "IHDR", 4) != 0) {
+        return false;
+    }
+    width = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+    height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+    return true;
+}
+
+
+TextureAtlas::TextureAtlas(void)
+{
+    // Initialize variables with default values
+    texture_ = 0;
+    width_ = 0;
+    height_ = 0;
+}
+
+
+TextureAtlas::~TextureAtlas()
+{
+
+    Release();
+}
+
+
+void TextureAtlas::Release(void)
+{
+    // Nothing was created without an OpenGL context (headless)
+    if (texture_) {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+        GLState::Invalidate();
+    }
+}
+
+
+int TextureAtlas::Add(const char *fname)
+{
+
+    return Add(fname, NULL, 0, 0);
+}
+
+
+int TextureAtlas::Add(const char *name, const unsigned char *pixels, int width, int height)
+{
+    Source source;
+    source.file = name;
+    source.pixels = pixels;
+    source.width = width;
+    source.height = height;
+    sources_.push_back(source);
+    return (int) sources_.size() - 1;
+}
+
+
+void TextureAtlas::Build(ThreadPool *pool)
+{
+    // An image and where it goes in the atlas
+    struct Image {
+        unsigned char *pixels;  // decoded early if the size was not in the header
+        int width;
+        int height;
+        int x;
+        int y;
+        GLuint pbo;             // pixel buffer the image is decoded into
+        unsigned char *mapped;  // mapped memory of the pixel buffer
+    };
+
+    // Find the size of all images
+    // Decoded images and PNG headers give it without decoding, anything
+    // else is decoded here
+    std::vector<Image> images(sources_.size());
+    int widest = 0;
+    for (int i = 0; i < sources_.size(); i++) {
+        const Source &source = sources_[i];
+        images[i].pixels = NULL;
+        if (source.pixels) {
+            images[i].width = source.width;
+            images[i].height = source.height;
+        } else if (!ReadPngSize(source.file, images[i].width, images[i].height)) {
+            images[i].pixels = SOIL_load_image(source.file.c_str(), &images[i].width, &images[i].height, 0, SOIL_LOAD_RGBA);
+            if (!images[i].pixels) {
+                throw(std::runtime_error(std::string("Could not load texture ") + source.file));
+            }
+        }
+        widest = std::max(widest, images[i].width + 2 * atlas_padding_g);
+    }
+
+    // Pack the images on shelves, tallest first, so that each shelf wastes
+    // little space
+    std::vector<int> order(images.size());
+    for (int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&images](int a, int b) {
+        return images[a].height > images[b].height;
+    });
+
+    width_ = std::max(widest, atlas_min_width_g);
+    int x = 0;
+    int y = 0;
+    int shelf_height = 0;
+    for (int i = 0; i < order.size(); i++) {
+        Image &image = images[order[i]];
+        int w = image.width + 2 * atlas_padding_g;
+        int h = image.height + 2 * atlas_padding_g;
+
+        // Start a new shelf when the current one is full
+        if (x + w > width_) {
+            y += shelf_height;
+            x = 0;
+            shelf_height = 0;
+        }
+        image.x = x + atlas_padding_g;
+        image.y = y + atlas_padding_g;
+        x += w;
+        shelf_height = std::max(shelf_height, h);
+    }
+    height_ = y + shelf_height;
+
+    // Check that the hardware can hold the atlas
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    if (max_size > 0 && (width_ > max_size || height_ > max_size)) {
+        for (int i = 0; i < images.size(); i++) {
+            SOIL_free_image_data(images[i].pixels);
+        }
+        throw(std::runtime_error(std::string("Texture atlas is too large: ") + std::to_string(width_) + "x" + std::to_string(height_)));
+    }
+
+    // Allocate the atlas, the images are copied in as they are decoded
+    glGenTextures(1, &texture_);
+    GLState::BindTexture(GL_TEXTURE_2D, texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    // Texture Wrapping
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Texture Filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Map a pixel buffer for each image, including its border
+    // Only this thread can talk to OpenGL, the workers just fill the memory
+    for (int i = 0; i < images.size(); i++) {
+        Image &image = images[i];
+        GLsizeiptr size = (GLsizeiptr) (image.width + 2 * atlas_padding_g) * (image.height + 2 * atlas_padding_g) * 4;
+        glGenBuffers(1, &image.pbo);
+        GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, image.pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        image.mapped = (unsigned char *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Images that finished decoding, in the order they finished
+    std::mutex mutex;
+    std::condition_variable decoded;
+    std::vector<int> finished;
+    std::string error;
+
+    // Decode the images on the workers
+    decode_ms_.assign(images.size(), 0.0);
+    upload_ms_.assign(images.size(), 0.0);
+    for (int i = 0; i < images.size(); i++) {
+        std::function<void(void)> task = [this, i, &images, &mutex, &decoded, &finished, &error]() {
+            PROFILE_SCOPE("Decode texture");
+            Image &image = images[i];
+            auto start = std::chrono::steady_clock::now();
+
+            // Decode the image, unless it was decoded already
+            const Source &source = sources_[i];
+            int width = image.width;
+            int height = image.height;
+            const unsigned char *pixels = source.pixels;
+            if (!pixels) {
+                if (!image.pixels) {
+                    image.pixels = SOIL_load_image(source.file.c_str(), &width, &height, 0, SOIL_LOAD_RGBA);
+                }
+                pixels = image.pixels;
+            }
+
+            // Copy it into the pixel buffer with a transparent border
+            bool ok = pixels && image.mapped && width == image.width && height == image.height;
+            if (ok) {
+                int row_size = (image.width + 2 * atlas_padding_g) * 4;
+                memset(image.mapped, 0, (size_t) row_size * (image.height + 2 * atlas_padding_g));
+                for (int row = 0; row < image.height; row++) {
+                    memcpy(&image.mapped[(row + atlas_padding_g) * row_size + atlas_padding_g * 4], &pixels[row * image.width * 4], image.width * 4);
+                }
+            }
+            SOIL_free_image_data(image.pixels);
+            image.pixels = NULL;
+            decode_ms_[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // Hand the image back for uploading
+            // Notify under the lock: once the last image is in, Build may
+            // return and destroy the condition variable
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ok && error.empty()) {
+                error = std::string("Could not load texture ") + sources_[i].file;
+            }
+            finished.push_back(i);
+            decoded.notify_one();
+        };
+
+        if (pool) {
+            pool->Submit(task);
+        } else {
+            task();
+        }
+    }
+
+    // Upload each image as soon as it is decoded, while the rest are still
+    // being decoded
+    for (int n = 0; n < images.size(); n++) {
+        // The error is read under the lock, a worker may still be setting it
+        int i;
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decoded.wait(lock, [n, &finished] { return finished.size() > n; });
+            i = finished[n];
+            failed = !error.empty();
+        }
+        Image &image = images[i];
+        auto start = std::chrono::steady_clock::now();
+
+        GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, image.pbo);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        if (!failed) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, image.x - atlas_padding_g, image.y - atlas_padding_g,
+                            image.width + 2 * atlas_padding_g, image.height + 2 * atlas_padding_g,
+                            GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        }
+        upload_ms_[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Release the pixel buffers
+    for (int i = 0; i < images.size(); i++) {
+        glDeleteBuffers(1, &images[i].pbo);
+    }
+    GLState::Invalidate();
+
+    // Every image was taken from the list under the lock, so the workers are
+    // done with the error
+    if (!error.empty()) {
+        throw(std::runtime_error(error));
+    }
+
+    // Compute the texture coordinates of the regions
+    // Coordinates are inset by half a texel, so that the border is never sampled
+    regions_.resize(images.size());
+    sizes_.resize(images.size());
+    for (int i = 0; i < images.size(); i++) {
+        Image &image = images[i];
+        sizes_[i] = glm::ivec2(image.width, image.height);
+        regions_[i] = glm::vec4((image.x + 0.5f) / width_, (image.y + 0.5f) / height_,
+                                (image.width - 1.0f) / width_, (image.height - 1.0f) / height_);
+    }
+}
+
+} // namespace game
@@ -0,0 +1,96 @@
+#ifndef TEXTURE_ATLAS_H_
+#define TEXTURE_ATLAS_H_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "thread_pool.h"
+
+namespace game {
+
+    /*
+        TextureAtlas packs all sprite images into a single texture
+        Every image becomes a region of the atlas, referenced by its index,
+        so objects with different images can be drawn without switching
+        textures
+    */
+    class TextureAtlas {
+
+        public:
+            // Constructor and destructor
+            TextureAtlas(void);
+            ~TextureAtlas();
+
+            // Delete the atlas texture, while the OpenGL context is still
+            // there (the destructor does it otherwise)
+            void Release(void);
+
+            // Queue an image file to be packed, returns the index of its region
+            // Indices are valid right away, even before Build() is called
+            int Add(const char *fname);
+
+            // Queue an image that is already decoded to RGBA8, returns the
+            // index of its region. The pixels are not copied and must stay
+            // valid until Build() returns
+            int Add(const char *name, const unsigned char *pixels, int width, int height);
+
+            // Load and pack all queued images and upload the atlas texture
+            // Images are decoded (or copied, if already decoded) on the
+            // pool's workers (if any) straight into pixel buffer objects, and
+            // each one is uploaded as soon as it is ready while the others
+            // are still decoding. Needs an OpenGL context on the calling thread
+            void Build(ThreadPool *pool);
+
+            // Getters
+            inline GLuint GetTexture(void) { return texture_; }
+            inline int GetWidth(void) { return width_; }
+            inline int GetHeight(void) { return height_; }
+            inline int GetNumRegions(void) { return (int) sources_.size(); }
+
+            // Texture coordinates of the regions as (u, v, width, height),
+            // valid after Build()
+            inline const glm::vec4 *GetRegions(void) { return regions_.data(); }
+
+            // Size of a region's image in pixels, valid after Build()
+            inline glm::ivec2 GetRegionSize(int region) { return sizes_[region]; }
+
+            // Time spent decoding and uploading a region's image in
+            // milliseconds, valid after Build()
+            inline double GetDecodeTime(int region) { return decode_ms_[region]; }
+            inline double GetUploadTime(int region) { return upload_ms_[region]; }
+
+        private:
+            // Reference to the atlas texture
+            GLuint texture_;
+
+            // Size of the atlas in pixels
+            int width_;
+            int height_;
+
+            // An image to pack: a file to decode, or pixels decoded already
+            struct Source {
+                std::string file;
+                const unsigned char *pixels;
+                int width;
+                int height;
+            };
+
+            // Images in the order they were added
+            std::vector<Source> sources_;
+
+            // Texture coordinates and size in pixels of each region
+            std::vector<glm::vec4> regions_;
+            std::vector<glm::ivec2> sizes_;
+
+            // Load times of each region
+            std::vector<double> decode_ms_;
+            std::vector<double> upload_ms_;
+
+    }; // class TextureAtlas
+
+} // namespace game
+
+#endif // TEXTURE_ATLAS_H_
@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "profiler.h"
+#include "thread_pool.h"
+
+namespace game {
+
+ThreadPool::ThreadPool(void)
+{
+    // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    pending_ = 0;
+    stop_ = false;
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    // Let the workers finish their current task and exit
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    task_ready_.notify_all();
+    for (int i = 0; i < threads_.size(); i++) {
+        threads_[i].join();
+    }
+}
+
+
+void ThreadPool::Init(int num_threads)
+{
+    if (num_threads <= 0) {
+        num_threads = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < num_threads; i++) {
+        threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+    }
+}
+
+
+void ThreadPool::Submit(std::function<void(void)> task)
+{
+    // Without workers the task runs right away
+    if (threads_.empty()) {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(task);
+        pending_++;
+    }
+    task_ready_.notify_one();
+}
+
+
+void ThreadPool::Wait(void)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+
+void ThreadPool::WorkerLoop(void)
+{
+    PROFILE_THREAD("loader");
+    while (true) {
+        // Wait for a task
+        std::function<void(void)> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_ready_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = tasks_.front();
+            tasks_.pop_front();
+        }
+
+        // Run it outside the lock
+        task();
+
+        // Signal waiters once everything is done
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_--;
+        }
+        task_done_.notify_all();
+    }
+}
+
+} // namespace game
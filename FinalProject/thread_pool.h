@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace game {
+
+    // A fixed set of worker threads that run tasks from a shared queue
+    class ThreadPool {
+
+        public:
+            // Constructor and destructor
+            ThreadPool(void);
+            ~ThreadPool();
+
+            // Start the worker threads (0 uses one thread per core)
+            void Init(int num_threads = 0);
+
+            // Queue a task to run on one of the workers
+            void Submit(std::function<void(void)> task);
+
+            // Wait until every queued task has finished
+            void Wait(void);
+
+            // Getter
+            inline int GetNumThreads(void) { return (int) threads_.size(); }
+
+        private:
+            // Worker threads
+            std::vector<std::thread> threads_;
+
+            // Tasks waiting to run
+            std::deque<std::function<void(void)> > tasks_;
+
+            // Number of tasks queued or running
+            int pending_;
+
+            // Tells the workers to exit
+            bool stop_;
+
+            // Protects the queue, signals new tasks and finished tasks
+            std::mutex mutex_;
+            std::condition_variable task_ready_;
+            std::condition_variable task_done_;
+
+            // Main function of a worker thread
+            void WorkerLoop(void);
+
+    }; // class ThreadPool
+
+} // namespace game
+
+#endif // THREAD_POOL_H_
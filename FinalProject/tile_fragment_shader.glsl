@@ -0,0 +1,17 @@
+// Source code of fragment shader
+#version 140
+
+// Attributes passed from the vertex shader
+in vec2 uv_interp;
+
+// Texture sampler (the texture atlas)
+uniform sampler2D onetex;
+
+// Output color
+out vec4 frag_color;
+
+void main()
+{
+    // Tiles are opaque
+    frag_color = vec4(texture(onetex, uv_interp).rgb, 1.0);
+}
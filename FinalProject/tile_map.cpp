@@ -0,0 +1,295 @@
+#include <math.h>
+#include <stddef.h>
+
+#include "gl_state.h"
+#include "geometry.h"
+#include "profiler.h"
+#include "tile_map.h"
+
+namespace game {
+
+// Size of a tile in world units and number of tiles along a chunk side
+const float tile_size_g = 2.5f;
+const int chunk_tiles_g = 8;
+const float chunk_size_g = tile_size_g * chunk_tiles_g;
+
+// The tile image is cut into a grid of this many images per side
+const int tile_images_g = 4;
+
+// Chunks kept at once, enough for the chunks around a view of up to three
+// chunks across
+const int tile_map_slots_g = 16;
+
+// Chunks are streamed in this far around the view, so that they are ready
+// before they scroll into it
+const float tile_map_prefetch_g = 0.5f * chunk_size_g;
+
+// Vertices of a chunk, two triangles per tile
+const int chunk_vertices_g = chunk_tiles_g * chunk_tiles_g * 6;
+
+
+// Image shown on a tile, picked by hashing its coordinates so that the same
+// tile always looks the same
+static int TileImage(int tile_x, int tile_y)
+{
+    unsigned int h = (unsigned int) tile_x * 73856093u ^ (unsigned int) tile_y * 19349663u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return (int) (h % (tile_images_g * tile_images_g));
+}
+
+
+TileMap::TileMap(void)
+{
+    // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    shader_ = NULL;
+    pool_ = NULL;
+    atlas_ = NULL;
+    frame_ = 0;
+    num_baked_ = 0;
+    num_evicted_ = 0;
+    num_drawn_ = 0;
+}
+
+
+TileMap::~TileMap()
+{
+
+    Release();
+}
+
+
+void TileMap::Release(void)
+{
+    // Let the chunks being baked finish before their slots go away
+    if (pool_) {
+        pool_->Wait();
+    }
+    for (int i = 0; i < chunks_.size(); i++) {
+        glDeleteBuffers(1, &chunks_[i].vbo);
+        glDeleteVertexArrays(1, &chunks_[i].vao);
+    }
+    chunks_.clear();
+    atlas_ = NULL;
+}
+
+
+void TileMap::Init(Shader *shader, ThreadPool *pool)
+{
+    shader_ = shader;
+    pool_ = pool;
+
+    // Allocate every slot up front, with a buffer of the size of a chunk
+    chunks_.resize(tile_map_slots_g);
+    for (int i = 0; i < chunks_.size(); i++) {
+        Chunk &chunk = chunks_[i];
+        chunk.chunk_x = 0;
+        chunk.chunk_y = 0;
+        chunk.state = CHUNK_EMPTY;
+        chunk.last_used = 0;
+        chunk.vertices.resize(chunk_vertices_g);
+
+        // The vertex array records the buffer and its layout
+        glGenVertexArrays(1, &chunk.vao);
+        GLState::BindVertexArray(chunk.vao);
+        glGenBuffers(1, &chunk.vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        glBufferData(GL_ARRAY_BUFFER, chunk_vertices_g * sizeof(TileVertex), NULL, GL_STATIC_DRAW);
+        glVertexAttribPointer(ATTRIB_VERTEX, 2, GL_FLOAT, GL_FALSE, sizeof(TileVertex), (void *) offsetof(TileVertex, x));
+        glEnableVertexAttribArray(ATTRIB_VERTEX);
+        glVertexAttribPointer(ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, sizeof(TileVertex), (void *) offsetof(TileVertex, u));
+        glEnableVertexAttribArray(ATTRIB_UV);
+    }
+}
+
+
+void TileMap::SetAtlas(TextureAtlas *atlas, int region)
+{
+
+    atlas_ = atlas;
+    region_ = atlas->GetRegions()[region];
+}
+
+
+void TileMap::Draw(const ViewRect &view)
+{
+    if (!atlas_) {
+        return;
+    }
+    frame_++;
+
+    // Chunks around the view, and the ones actually in it
+    int first_x = (int) floorf((view.min_x - tile_map_prefetch_g) / chunk_size_g);
+    int last_x = (int) floorf((view.max_x + tile_map_prefetch_g) / chunk_size_g);
+    int first_y = (int) floorf((view.min_y - tile_map_prefetch_g) / chunk_size_g);
+    int last_y = (int) floorf((view.max_y + tile_map_prefetch_g) / chunk_size_g);
+    int view_first_x = (int) floorf(view.min_x / chunk_size_g);
+    int view_last_x = (int) floorf(view.max_x / chunk_size_g);
+    int view_first_y = (int) floorf(view.min_y / chunk_size_g);
+    int view_last_y = (int) floorf(view.max_y / chunk_size_g);
+
+    // Keep the chunks around the view and claim slots for the missing
+    // ones, the chunks in view first
+    visible_.clear();
+    baking_.clear();
+    in_view_baking_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int pass = 0; pass < 2; pass++) {
+            for (int cy = first_y; cy <= last_y; cy++) {
+                for (int cx = first_x; cx <= last_x; cx++) {
+                    bool in_view = cx >= view_first_x && cx <= view_last_x && cy >= view_first_y && cy <= view_last_y;
+                    if (in_view != (pass == 0)) {
+                        continue;
+                    }
+                    int slot = FindChunk(cx, cy);
+                    if (slot < 0) {
+                        slot = FindFreeSlot();
+                        if (slot < 0) {
+                            continue;
+                        }
+                        Chunk &chunk = chunks_[slot];
+                        if (chunk.state != CHUNK_EMPTY) {
+                            num_evicted_++;
+                        }
+                        chunk.chunk_x = cx;
+                        chunk.chunk_y = cy;
+                        chunk.state = CHUNK_BAKING;
+                        baking_.push_back(slot);
+                        in_view_baking_.push_back(in_view);
+                    }
+                    chunks_[slot].last_used = frame_;
+                    if (in_view) {
+                        visible_.push_back(slot);
+                    }
+                }
+            }
+        }
+    }
+
+    // Bake the new chunks around the view on the workers
+    // A chunk already in view (at the start, or after the camera jumped)
+    // is baked right away instead, so that it never shows up late
+    for (int i = 0; i < baking_.size(); i++) {
+        Chunk *chunk = &chunks_[baking_[i]];
+        if (pool_ && !in_view_baking_[i]) {
+            pool_->Submit([this, chunk]() { Bake(chunk); });
+        } else {
+            Bake(chunk);
+        }
+    }
+
+    // Upload the chunks that finished baking
+    for (int i = 0; i < chunks_.size(); i++) {
+        Chunk &chunk = chunks_[i];
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (chunk.state == CHUNK_BAKED) {
+            GLState::BindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, chunk_vertices_g * sizeof(TileVertex), chunk.vertices.data());
+            chunk.state = CHUNK_RESIDENT;
+        }
+    }
+
+    // Draw the chunks in view
+    shader_->Enable();
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthFunc(GL_LESS);
+    GLState::Disable(GL_BLEND);
+    GLState::BindTexture(GL_TEXTURE_2D, atlas_->GetTexture());
+    for (int i = 0; i < visible_.size(); i++) {
+        Chunk &chunk = chunks_[visible_[i]];
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (chunk.state != CHUNK_RESIDENT) {
+                continue;
+            }
+        }
+        GLState::BindVertexArray(chunk.vao);
+        glDrawArrays(GL_TRIANGLES, 0, chunk_vertices_g);
+        num_drawn_++;
+    }
+}
+
+
+int TileMap::FindChunk(int chunk_x, int chunk_y)
+{
+    for (int i = 0; i < chunks_.size(); i++) {
+        if (chunks_[i].state != CHUNK_EMPTY && chunks_[i].chunk_x == chunk_x && chunks_[i].chunk_y == chunk_y) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+int TileMap::FindFreeSlot(void)
+{
+    // An empty slot, or else the one not needed for the longest time
+    // Slots in use this frame and slots a worker is filling are kept
+    int best = -1;
+    for (int i = 0; i < chunks_.size(); i++) {
+        const Chunk &chunk = chunks_[i];
+        if (chunk.state == CHUNK_EMPTY) {
+            return i;
+        }
+        if (chunk.state == CHUNK_BAKING || chunk.last_used == frame_) {
+            continue;
+        }
+        if (best < 0 || chunk.last_used < chunks_[best].last_used) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+
+void TileMap::Bake(Chunk *chunk)
+{
+    PROFILE_SCOPE("Bake tile chunk");
+
+    // Size of one tile image in the atlas
+    float image_w = region_.z / tile_images_g;
+    float image_h = region_.w / tile_images_g;
+
+    TileVertex *v = chunk->vertices.data();
+    for (int ty = 0; ty < chunk_tiles_g; ty++) {
+        for (int tx = 0; tx < chunk_tiles_g; tx++) {
+            // Corners of the tile in the world
+            int tile_x = chunk->chunk_x * chunk_tiles_g + tx;
+            int tile_y = chunk->chunk_y * chunk_tiles_g + ty;
+            float x0 = tile_x * tile_size_g;
+            float y0 = tile_y * tile_size_g;
+            float x1 = x0 + tile_size_g;
+            float y1 = y0 + tile_size_g;
+
+            // Corners of its image, the top of an image is at its lowest v
+            int image = TileImage(tile_x, tile_y);
+            float u0 = region_.x + (image % tile_images_g) * image_w;
+            float v0 = region_.y + (image / tile_images_g) * image_h;
+            float u1 = u0 + image_w;
+            float v1 = v0 + image_h;
+
+            // Two triangles, as the sprite quad
+            TileVertex top_left = { x0, y1, u0, v0 };
+            TileVertex top_right = { x1, y1, u1, v0 };
+            TileVertex bottom_right = { x1, y0, u1, v1 };
+            TileVertex bottom_left = { x0, y0, u0, v1 };
+            *v++ = top_left;
+            *v++ = top_right;
+            *v++ = bottom_right;
+            *v++ = bottom_right;
+            *v++ = bottom_left;
+            *v++ = top_left;
+        }
+    }
+
+    // Hand the chunk over for the upload
+    std::lock_guard<std::mutex> lock(mutex_);
+    chunk->state = CHUNK_BAKED;
+    num_baked_++;
+}
+
+} // namespace game
@@ -0,0 +1,131 @@
+#ifndef TILE_MAP_H_
+#define TILE_MAP_H_
+
+#include <mutex>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "shader.h"
+#include "texture_atlas.h"
+#include "thread_pool.h"
+#include "render_queue.h"
+
+namespace game {
+
+    // A vertex of a baked tile: position in the world and texture
+    // coordinates in the atlas
+    struct TileVertex {
+        float x;
+        float y;
+        float u;
+        float v;
+    };
+
+    /*
+        TileMap draws the background as an endless map of static tiles
+        The map is cut into square chunks of tiles. A chunk is baked once
+        into its own vertex buffer and then drawn with a single call, so the
+        cost of a frame depends on the chunks in view, not on the number of
+        tiles. Only the chunks near the camera are kept: a fixed set of
+        slots is filled as the camera moves, the chunks are baked on the
+        pool's workers and uploaded by the render thread, and the slots of
+        chunks that fell out of range are reused. Memory stays the same
+        however large the map is
+
+        All calls must come from the thread that owns the OpenGL context
+    */
+    class TileMap {
+
+        public:
+            // Constructor and destructor
+            TileMap(void);
+            ~TileMap();
+
+            // Create the chunk slots and their buffers (called once)
+            // Chunks are baked on the pool's workers, or right away without
+            // a pool
+            void Init(Shader *shader, ThreadPool *pool);
+
+            // Delete the chunk buffers, while the OpenGL context is still
+            // there (the destructor does it otherwise)
+            void Release(void);
+
+            // Show an atlas region on the tiles, once the atlas has been built
+            // The image is cut into a grid of tile images, each tile shows
+            // one of them
+            void SetAtlas(TextureAtlas *atlas, int region);
+
+            // Stream in the chunks around the view, upload the ones that
+            // finished baking and draw the ones in view, one call each
+            void Draw(const ViewRect &view);
+
+            // Statistics
+            inline int GetNumSlots(void) { return (int) chunks_.size(); }
+            inline int GetNumFrames(void) { return frame_; }
+            inline long long GetNumBaked(void) { return num_baked_; }
+            inline long long GetNumEvicted(void) { return num_evicted_; }
+            inline long long GetNumDrawn(void) { return num_drawn_; }
+
+        private:
+            // Life of a slot: empty, waiting for a worker to bake a chunk,
+            // baked and waiting for the upload, then drawn from its buffer
+            enum ChunkState {
+                CHUNK_EMPTY = 0,
+                CHUNK_BAKING,
+                CHUNK_BAKED,
+                CHUNK_RESIDENT
+            };
+
+            // A slot holding one chunk
+            struct Chunk {
+                int chunk_x;
+                int chunk_y;
+                ChunkState state;
+                int last_used;
+                GLuint vao;
+                GLuint vbo;
+                std::vector<TileVertex> vertices;
+            };
+
+            // Shader of the tiles, and the workers that bake the chunks
+            Shader *shader_;
+            ThreadPool *pool_;
+
+            // Atlas holding the tile images and the region they are in
+            TextureAtlas *atlas_;
+            glm::vec4 region_;
+
+            // Slots, with their state protected by the mutex (the workers
+            // only touch a slot while it is baking)
+            std::vector<Chunk> chunks_;
+            std::mutex mutex_;
+
+            // Frame counter, to reuse the slots that were not needed longest
+            int frame_;
+
+            // Slots in view and slots claimed for baking this frame, with
+            // whether each of those is in view (kept to avoid allocations)
+            std::vector<int> visible_;
+            std::vector<int> baking_;
+            std::vector<bool> in_view_baking_;
+
+            // Statistics
+            long long num_baked_;
+            long long num_evicted_;
+            long long num_drawn_;
+
+            // Find the slot holding a chunk, -1 if none
+            int FindChunk(int chunk_x, int chunk_y);
+
+            // Pick a slot for a new chunk, -1 if all are in use
+            int FindFreeSlot(void);
+
+            // Fill the vertices of a slot with the tiles of its chunk
+            void Bake(Chunk *chunk);
+
+    }; // class TileMap
+
+} // namespace game
+
+#endif // TILE_MAP_H_
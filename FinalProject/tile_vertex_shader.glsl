@@ -0,0 +1,23 @@
+// Source code of vertex shader
+#version 140
+
+// Vertex buffer of a chunk (world position and atlas coordinates)
+in vec2 vertex;
+in vec2 uv;
+
+// Camera data, one uniform buffer shared by all draws of a frame
+layout(std140) uniform Camera {
+    mat4 view_matrix;
+};
+
+// Attributes forwarded to the fragment shader
+out vec2 uv_interp;
+
+void main()
+{
+    // Tiles are baked in world coordinates
+    gl_Position = view_matrix * vec4(vertex, 0.0, 1.0);
+
+    // Pass attributes to fragment shader
+    uv_interp = uv;
+}
@@ -0,0 +1,59 @@
+#include <stddef.h>
+
+#include "gl_state.h"
+#include "uniform_buffer.h"
+
+namespace game {
+
+UniformBuffer::UniformBuffer(void)
+{
+    // Don't do work in the constructor, leave it for the Init() function
+
+    // Only initialize variables with default values
+    ubo_ = 0;
+    size_ = 0;
+    binding_ = 0;
+}
+
+
+UniformBuffer::~UniformBuffer()
+{
+
+    Release();
+}
+
+
+void UniformBuffer::Release(void)
+{
+    // Nothing was created without an OpenGL context (headless)
+    if (ubo_) {
+        glDeleteBuffers(1, &ubo_);
+        ubo_ = 0;
+    }
+}
+
+
+void UniformBuffer::Init(GLsizeiptr size, GLuint binding)
+{
+    size_ = size;
+    binding_ = binding;
+
+    // Create the buffer
+    glGenBuffers(1, &ubo_);
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    glBufferData(GL_UNIFORM_BUFFER, size_, NULL, GL_DYNAMIC_DRAW);
+
+    // Attach it to the binding point for all shaders to use
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding_, ubo_);
+}
+
+
+void UniformBuffer::Update(const void *data)
+{
+    // Orphan the old storage so the update does not wait for draws still using it
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    glBufferData(GL_UNIFORM_BUFFER, size_, NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size_, data);
+}
+
+} // namespace game
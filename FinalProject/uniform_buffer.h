@@ -0,0 +1,46 @@
+#ifndef UNIFORM_BUFFER_H_
+#define UNIFORM_BUFFER_H_
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace game {
+
+    // A uniform buffer object, shared by every shader that declares a
+    // matching uniform block bound to the same binding point
+    class UniformBuffer {
+
+        public:
+            // Constructor and destructor
+            UniformBuffer(void);
+            ~UniformBuffer();
+
+            // Create the buffer with a fixed size and attach it to a binding point
+            void Init(GLsizeiptr size, GLuint binding);
+
+            // Replace the contents of the buffer
+            void Update(const void *data);
+
+            // Delete the buffer, while the OpenGL context is still there
+            // (the destructor does it otherwise)
+            void Release(void);
+
+            // Getters
+            inline GLuint GetBuffer(void) { return ubo_; }
+            inline GLuint GetBinding(void) { return binding_; }
+
+        private:
+            // Reference to the buffer
+            GLuint ubo_;
+
+            // Size of the buffer in bytes
+            GLsizeiptr size_;
+
+            // Binding point the buffer is attached to
+            GLuint binding_;
+
+    }; // class UniformBuffer
+
+} // namespace game
+
+#endif // UNIFORM_BUFFER_H_